@@ -0,0 +1,500 @@
+///
+/// @file
+/// This file contains the implementation of the multivariate normal random
+/// distribution with stationary covariance on regular 1-D and 2-D grids,
+/// sampled using the circulant embedding method.
+///
+
+#ifndef BAARAAN_CIRCULANT_MVNORM_DISTRIBUTION_H
+#define BAARAAN_CIRCULANT_MVNORM_DISTRIBUTION_H
+
+#include <armadillo>
+#include <complex>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "compiled.h"
+#include "snapshot.h"
+
+namespace baaraan {
+
+///
+/// @brief      Circulant Embedding Multivariate Normal Random Distribution
+///
+/// Draws stationary Gaussian random fields on a regular n1 x n2 grid, i.e.,
+/// Gaussian vectors with (block) Toeplitz covariance, without ever forming or
+/// factorizing the covariance matrix. The covariance is embedded in a
+/// (block) circulant matrix of size m1 x m2, whose eigenvalues are computed
+/// with a single FFT. Every draw then costs one complex FFT of size m1 x m2,
+/// i.e., O(n log n) time and O(n) memory, and yields two independent fields,
+/// one from the real and one from the imaginary part.
+///
+/// 1-D grids are represented as n x 1 grids, and therefore return n x 1
+/// matrices.
+///
+/// @tparam     RealType  Indicates the type of return values
+///
+/// @ingroup    MultivariateDistribution
+///
+template <class RealType = double> class circulant_mvnorm_distribution {
+public:
+  // types
+  typedef arma::Mat<RealType> matrix_type;
+  typedef arma::Col<RealType> vector_type;
+  typedef arma::Cube<RealType> cube_type;
+  typedef arma::Mat<std::complex<RealType>> cx_matrix_type;
+
+  //! Covariance as a function of the (signed) lags along each grid axis
+  typedef std::function<RealType(RealType, RealType)> covariance_function;
+
+  ///
+  /// @brief      Circulant Embedding Distribution Parameter Type
+  ///
+  class param_type {
+    size_t n_rows_;
+    size_t n_cols_;
+    RealType mean_;
+
+    //! Size of the circulant embedding
+    size_t m_rows_;
+    size_t m_cols_;
+
+    //! sqrt(eigenvalues / (m1 * m2)) of the circulant embedding
+    matrix_type sqrt_eigs_;
+
+    static size_t next_pow2(size_t x) {
+      size_t m = 1;
+      while (m < x)
+        m <<= 1;
+      return m;
+    }
+
+    static long lag(size_t i, size_t m) {
+      return i <= m / 2 ? static_cast<long>(i)
+                        : static_cast<long>(i) - static_cast<long>(m);
+    }
+
+    ///
+    /// Evaluates the first block row of the m1 x m2 embedding, and checks
+    /// whether its eigenvalues are nonnegative.
+    ///
+    bool embed(const covariance_function &cov, RealType h1, RealType h2,
+               size_t m1, size_t m2) {
+      matrix_type base(m1, m2);
+      for (size_t j = 0; j < m2; ++j)
+        for (size_t i = 0; i < m1; ++i)
+          base(i, j) = cov(lag(i, m1) * h1, lag(j, m2) * h2);
+
+      matrix_type eigs = arma::real(arma::fft2(base));
+
+      // round-off in the FFT produces tiny negative eigenvalues even for
+      // valid embeddings
+      const RealType tol =
+          1e3 * std::numeric_limits<RealType>::epsilon() * eigs.max();
+      if (eigs.min() < -tol)
+        return false;
+
+      eigs.clamp(0, std::numeric_limits<RealType>::max());
+
+      m_rows_ = m1;
+      m_cols_ = m2;
+      sqrt_eigs_ = arma::sqrt(eigs / static_cast<RealType>(m1 * m2));
+      return true;
+    }
+
+    static std::string embedding_error(size_t m1, size_t m2) {
+      return "Circulant embedding is not nonnegative definite, even at size " +
+             std::to_string(m1) + " x " + std::to_string(m2) +
+             ". The covariance is not embeddable on this grid, try a larger "
+             "max_padding or a smaller grid.";
+    }
+
+    param_type() : n_rows_(0), n_cols_(0), mean_(0), m_rows_(0), m_cols_(0) {}
+
+  public:
+    typedef circulant_mvnorm_distribution distribution_type;
+
+    ///
+    /// @brief      Constructs the parameters of a stationary field on an
+    /// n1 x n2 grid from its covariance function.
+    ///
+    /// The embedding starts at the smallest power of two that holds the grid,
+    /// and is doubled, up to max_padding times, until it is nonnegative
+    /// definite.
+    ///
+    /// @param[in]  n1           Number of grid points along the first axis
+    /// @param[in]  n2           Number of grid points along the second axis
+    /// @param[in]  h1           Grid spacing along the first axis
+    /// @param[in]  h2           Grid spacing along the second axis
+    /// @param[in]  cov          The covariance as a function of the lags
+    /// @param[in]  mean         The mean of the field
+    /// @param[in]  max_padding  Maximum number of embedding doublings
+    ///
+    explicit param_type(size_t n1, size_t n2, RealType h1, RealType h2,
+                        covariance_function cov, RealType mean = 0,
+                        size_t max_padding = 4)
+        : n_rows_(n1), n_cols_(n2), mean_(mean) {
+
+      if (n1 == 0 || n2 == 0)
+        throw std::length_error("Grid should have at least one point.");
+
+      size_t m1 = n1 > 1 ? next_pow2(2 * (n1 - 1)) : 1;
+      size_t m2 = n2 > 1 ? next_pow2(2 * (n2 - 1)) : 1;
+
+      for (size_t k = 0; !embed(cov, h1, h2, m1, m2); ++k) {
+        if (k == max_padding)
+          throw std::logic_error(embedding_error(m1, m2));
+
+        m1 = n1 > 1 ? 2 * m1 : 1;
+        m2 = n2 > 1 ? 2 * m2 : 1;
+      }
+    }
+
+    ///
+    /// @brief      Constructs the parameters of a stationary process on a
+    /// 1-D grid from its covariance function.
+    ///
+    explicit param_type(size_t n, RealType h,
+                        std::function<RealType(RealType)> cov,
+                        RealType mean = 0, size_t max_padding = 4)
+        : param_type(n, 1, h, 1,
+                     [cov](RealType dx, RealType) { return cov(dx); }, mean,
+                     max_padding) {}
+
+    ///
+    /// @brief      Constructs the parameters of a Gaussian vector with a
+    /// symmetric Toeplitz covariance, given by its first row.
+    ///
+    /// Since the covariance is unknown beyond the given lags, the minimal
+    /// embedding of size 2(n - 1) is used, and it cannot be padded.
+    ///
+    /// @param[in]  first_row  First row of the Toeplitz covariance matrix
+    /// @param[in]  mean       The mean of every coordinate
+    ///
+    explicit param_type(vector_type first_row, RealType mean = 0)
+        : n_rows_(first_row.n_elem), n_cols_(1), mean_(mean) {
+
+      if (first_row.n_elem == 0)
+        throw std::length_error("First row should not be empty.");
+
+      const size_t m = n_rows_ > 1 ? 2 * (n_rows_ - 1) : 1;
+      auto cov = [&first_row](RealType dx, RealType) {
+        return first_row(static_cast<size_t>(std::abs(dx)));
+      };
+
+      if (!embed(cov, 1, 1, m, 1))
+        throw std::logic_error(embedding_error(m, 1));
+    }
+
+    //! Returns the number of grid points along the first axis
+    size_t n_rows() const { return n_rows_; }
+
+    //! Returns the number of grid points along the second axis
+    size_t n_cols() const { return n_cols_; }
+
+    //! Returns the mean of the field
+    RealType mean() const { return mean_; }
+
+    //! Returns the number of rows of the circulant embedding
+    size_t m_rows() const { return m_rows_; }
+
+    //! Returns the number of columns of the circulant embedding
+    size_t m_cols() const { return m_cols_; }
+
+    //! Returns the scaled square root of the embedding's eigenvalues
+    const matrix_type &sqrt_eigs() const { return sqrt_eigs_; }
+
+    //! Writes the grid, and the embedding's eigenvalues, to a binary snapshot
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_pod(os, static_cast<std::uint64_t>(n_rows_));
+      snapshot::write_pod(os, static_cast<std::uint64_t>(n_cols_));
+      snapshot::write_pod(os, mean_);
+      snapshot::write_matrix(os, sqrt_eigs_);
+    }
+
+    //! Reads the parameters written by save(), without recomputing the FFT
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      param_type p;
+      std::uint64_t n1{0}, n2{0};
+      snapshot::read_pod(is, n1);
+      snapshot::read_pod(is, n2);
+      snapshot::read_pod(is, p.mean_);
+      snapshot::read_matrix(is, p.sqrt_eigs_);
+
+      p.n_rows_ = n1;
+      p.n_cols_ = n2;
+      p.m_rows_ = p.sqrt_eigs_.n_rows;
+      p.m_cols_ = p.sqrt_eigs_.n_cols;
+      if (p.n_rows_ == 0 || p.n_cols_ == 0 || p.m_rows_ < p.n_rows_ ||
+          p.m_cols_ < p.n_cols_ || !p.sqrt_eigs_.is_finite() ||
+          p.sqrt_eigs_.min() < 0)
+        is.setstate(std::ios_base::failbit);
+
+      return p;
+    }
+
+    friend bool operator==(const param_type &x, const param_type &y) {
+      return x.n_rows_ == y.n_rows_ && x.n_cols_ == y.n_cols_ &&
+             x.mean_ == y.mean_ && x.m_rows_ == y.m_rows_ &&
+             x.m_cols_ == y.m_cols_ &&
+             arma::approx_equal(x.sqrt_eigs_, y.sqrt_eigs_, "absdiff", 0.001);
+    }
+
+    friend bool operator!=(const param_type &x, const param_type &y) {
+      return !(x == y);
+    }
+  };
+
+  ///
+  /// @brief      FFT buffer, and the spare imaginary half of the last FFT
+  ///
+  /// The spare field only belongs to the distribution that drew it, so a
+  /// context should not be passed to different distributions.
+  ///
+  struct context_type {
+    std::normal_distribution<RealType> norm; // N~(0, 1)
+    cx_matrix_type w;
+
+    //! The imaginary half of the last FFT, drawn with the default parameters
+    matrix_type spare;
+    bool has_spare{false};
+
+    void reset() {
+      norm.reset();
+      has_spare = false;
+    }
+  };
+
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+  ///
+  /// Runs one FFT and returns both fields through ctx.w, the real part and
+  /// the imaginary part are independent draws.
+  ///
+  template <class URNG>
+  static void draw_pair(URNG &g, context_type &ctx, const param_type &p) {
+    ctx.w.set_size(p.m_rows(), p.m_cols());
+
+    const RealType *s = p.sqrt_eigs().memptr();
+    std::complex<RealType> *w = ctx.w.memptr();
+    for (size_t i = 0; i < ctx.w.n_elem; ++i) {
+      RealType re = ctx.norm(g);
+      RealType im = ctx.norm(g);
+      w[i] = std::complex<RealType>(s[i] * re, s[i] * im);
+    }
+
+    ctx.w = arma::fft2(ctx.w);
+  }
+
+  static matrix_type real_part(const context_type &ctx, const param_type &p) {
+    return arma::real(ctx.w.submat(0, 0, p.n_rows() - 1, p.n_cols() - 1)) +
+           p.mean();
+  }
+
+  static matrix_type imag_part(const context_type &ctx, const param_type &p) {
+    return arma::imag(ctx.w.submat(0, 0, p.n_rows() - 1, p.n_cols() - 1)) +
+           p.mean();
+  }
+
+public:
+  // constructor and reset functions
+
+  ///
+  /// @brief      Constructs an instance of the distribution by accepting an
+  /// instance of circulant_mvnorm_distribution::param_type.
+  ///
+  /// @param[in]  p
+  ///
+  explicit circulant_mvnorm_distribution(const param_type &p) : p_(p) {}
+
+  ///
+  /// @brief      Constructs an instance of the distribution with a symmetric
+  /// Toeplitz covariance given by its first row.
+  ///
+  /// @param[in]  first_row  First row of the Toeplitz covariance matrix
+  /// @param[in]  mean       The mean of every coordinate
+  ///
+  explicit circulant_mvnorm_distribution(vector_type first_row,
+                                         RealType mean = 0)
+      : p_(param_type(first_row, mean)) {}
+
+  void reset() { ctx_.reset(); };
+
+  // generating functions
+  template <class URNG> matrix_type operator()(URNG &g) {
+    return (*this)(g, ctx_);
+  }
+
+  template <class URNG> matrix_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // batch generation
+  template <class URNG> cube_type operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  cube_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx) const {
+    if (ctx.has_spare) {
+      ctx.has_spare = false;
+      return ctx.spare;
+    }
+
+    draw_pair(g, ctx, p_);
+    ctx.spare = imag_part(ctx, p_);
+    ctx.has_spare = true;
+    return real_part(ctx, p_);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const {
+    draw_pair(g, ctx, p);
+    return real_part(ctx, p);
+  }
+
+  template <class URNG>
+  cube_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  cube_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                       size_t n) const;
+
+  // property functions
+
+  size_t n_rows() const { return p_.n_rows(); }
+
+  size_t n_cols() const { return p_.n_cols(); }
+
+  RealType mean() const { return p_.mean(); }
+
+  param_type param() const { return p_; }
+
+  void param(const param_type &p) {
+    p_ = p;
+    ctx_.has_spare = false;
+  }
+
+public:
+  matrix_type min() const {
+    return matrix_type(p_.n_rows(), p_.n_cols())
+        .fill(-std::numeric_limits<RealType>::infinity());
+  }
+
+  matrix_type max() const {
+    return matrix_type(p_.n_rows(), p_.n_cols())
+        .fill(+std::numeric_limits<RealType>::infinity());
+  }
+
+  friend bool operator==(const circulant_mvnorm_distribution &x,
+                         const circulant_mvnorm_distribution &y) {
+    return x.p_ == y.p_;
+  }
+
+  friend bool operator!=(const circulant_mvnorm_distribution &x,
+                         const circulant_mvnorm_distribution &y) {
+    return !(x == y);
+  }
+
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
+  template <class charT, class traits>
+  friend std::basic_ostream<charT, traits> &
+  operator<<(std::basic_ostream<charT, traits> &os,
+             const circulant_mvnorm_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::circulant_mvnorm,
+                           sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.norm);
+    snapshot::write_matrix(os, x.ctx_.spare);
+    snapshot::write_pod(os, x.ctx_.has_spare);
+    return os;
+  }
+
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
+  template <class charT, class traits>
+  friend std::basic_istream<charT, traits> &
+  operator>>(std::basic_istream<charT, traits> &is,
+             circulant_mvnorm_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::circulant_mvnorm,
+                               sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::normal_distribution<RealType> norm;
+    matrix_type spare;
+    bool has_spare;
+    snapshot::read_state(is, norm);
+    snapshot::read_matrix(is, spare);
+    snapshot::read_pod(is, has_spare);
+
+    if (has_spare &&
+        (spare.n_rows != p.n_rows() || spare.n_cols != p.n_cols()))
+      is.setstate(std::ios_base::failbit);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.norm = norm;
+      x.ctx_.spare = spare;
+      x.ctx_.has_spare = has_spare;
+    }
+    return is;
+  }
+};
+
+template <class RealType>
+template <class URNG>
+typename circulant_mvnorm_distribution<RealType>::cube_type
+circulant_mvnorm_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const circulant_mvnorm_distribution<RealType>::param_type &p,
+    size_t n) const {
+
+  cube_type res(p.n_rows(), p.n_cols(), n);
+
+  for (size_t k = 0; k < n; k += 2) {
+    draw_pair(g, ctx, p);
+    res.slice(k) = real_part(ctx, p);
+    if (k + 1 < n)
+      res.slice(k + 1) = imag_part(ctx, p);
+  }
+
+  return res;
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_CIRCULANT_MVNORM_INSTANCES(EXT)                               \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT,                          \
+                        circulant_mvnorm_distribution)                        \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             circulant_mvnorm_distribution, matrix_type)      \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_BATCH_INSTANCE, EXT,                     \
+                             circulant_mvnorm_distribution, cube_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_CIRCULANT_MVNORM_INSTANCES(extern)
+#endif
+
+} // namespace baaraan
+
+#endif // BAARAAN_CIRCULANT_MVNORM_DISTRIBUTION_H
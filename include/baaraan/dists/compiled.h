@@ -0,0 +1,66 @@
+///
+/// @file
+/// This file contains the macros used to declare and define the explicit
+/// instantiations of the distributions, provided by the optional
+/// `baaraan::compiled` library.
+///
+/// Every distribution header defines a `BAARAAN_<NAME>_INSTANCES(EXT)` macro
+/// listing its instantiations. When `BAARAAN_USE_COMPILED` is defined, which
+/// is done automatically by linking to `baaraan::compiled`, the header
+/// expands it with `extern`, so that the translation units of the consumer do
+/// not instantiate those templates again, and the compiled library expands
+/// it with an empty argument to provide them.
+///
+
+#ifndef BAARAAN_COMPILED_H
+#define BAARAAN_COMPILED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+//! Expands M for every real type provided by the compiled library
+#define BAARAAN_FOR_EACH_REAL(M, EXT, ...)                                    \
+  M(EXT, float, __VA_ARGS__)                                                   \
+  M(EXT, double, __VA_ARGS__)
+
+//! Expands M for every real type and engine provided by the compiled library
+#define BAARAAN_FOR_EACH_REAL_URNG(M, EXT, ...)                               \
+  M(EXT, float, std::mt19937, __VA_ARGS__)                                     \
+  M(EXT, float, std::mt19937_64, __VA_ARGS__)                                  \
+  M(EXT, double, std::mt19937, __VA_ARGS__)                                    \
+  M(EXT, double, std::mt19937_64, __VA_ARGS__)
+
+//! Expands M for every integer type provided by the compiled library, used
+//! by the distributions of counts
+#define BAARAAN_FOR_EACH_INT(M, EXT, ...)                                     \
+  M(EXT, int, __VA_ARGS__)                                                     \
+  M(EXT, std::int64_t, __VA_ARGS__)
+
+//! Expands M for every integer type and engine provided by the compiled
+//! library
+#define BAARAAN_FOR_EACH_INT_URNG(M, EXT, ...)                                \
+  M(EXT, int, std::mt19937, __VA_ARGS__)                                       \
+  M(EXT, int, std::mt19937_64, __VA_ARGS__)                                    \
+  M(EXT, std::int64_t, std::mt19937, __VA_ARGS__)                              \
+  M(EXT, std::int64_t, std::mt19937_64, __VA_ARGS__)
+
+//! The class itself, i.e., all its non-template members
+#define BAARAAN_CLASS_INSTANCE(EXT, REAL, DIST)                               \
+  EXT template class DIST<REAL>;
+
+//! The single draw, operator()(URNG &, context_type &, const param_type &),
+//! which all the other single draw overloads forward to
+#define BAARAAN_SAMPLER_INSTANCE(EXT, REAL, URNG, DIST, RESULT)               \
+  EXT template DIST<REAL>::RESULT DIST<REAL>::operator()(                     \
+      URNG &, DIST<REAL>::context_type &, const DIST<REAL>::param_type &)     \
+      const;
+
+//! The batch draw, operator()(URNG &, context_type &, const param_type &,
+//! size_t), which all the other batch overloads forward to
+#define BAARAAN_BATCH_INSTANCE(EXT, REAL, URNG, DIST, RESULT)                 \
+  EXT template DIST<REAL>::RESULT DIST<REAL>::operator()(                     \
+      URNG &, DIST<REAL>::context_type &, const DIST<REAL>::param_type &,     \
+      std::size_t) const;
+
+#endif // BAARAAN_COMPILED_H
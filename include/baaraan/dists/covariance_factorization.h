@@ -0,0 +1,101 @@
+///
+/// @file
+/// This file contains the lazily evaluated factorization of a covariance
+/// matrix, shared by the multivariate distributions' parameter types.
+///
+
+#ifndef BAARAAN_COVARIANCE_FACTORIZATION_H
+#define BAARAAN_COVARIANCE_FACTORIZATION_H
+
+#include <mutex>
+
+#include "../linalg/armadillo_backend.h"
+
+namespace baaraan {
+
+namespace detail {
+
+///
+/// @brief      Lazily evaluated factorization of a covariance matrix
+///
+/// Every derived quantity is computed on its first use, exactly once, even
+/// if several threads ask for it at the same time. Sampling, for instance,
+/// only pays for the Cholesky factor, while the inverse factor and the
+/// precision matrix are only computed when a density is evaluated.
+///
+/// The object is immutable from the outside, and it is meant to be shared
+/// between copies of a param_type through a std::shared_ptr.
+///
+/// @tparam     RealType  Indicates the type of the matrix elements
+/// @tparam     Backend   The linear algebra backend, see armadillo_backend.h
+///
+template <class RealType,
+          class Backend = linalg::armadillo_backend<RealType>>
+class covariance_factorization {
+public:
+  typedef typename Backend::matrix_type matrix_type;
+
+private:
+  matrix_type sigma_;
+
+  mutable std::once_flag lower_once_;
+  mutable std::once_flag inv_lower_once_;
+  mutable std::once_flag inv_once_;
+  mutable std::once_flag log_det_once_;
+
+  mutable matrix_type lower_;
+  mutable matrix_type inv_lower_;
+  mutable matrix_type inv_;
+  mutable RealType log_det_;
+
+public:
+  explicit covariance_factorization(matrix_type sigma)
+      : sigma_(std::move(sigma)) {}
+
+  //! Restores a factorization from a previously computed Cholesky factor
+  explicit covariance_factorization(matrix_type sigma, matrix_type lower)
+      : sigma_(std::move(sigma)) {
+    std::call_once(lower_once_, [&]() { lower_ = std::move(lower); });
+  }
+
+  covariance_factorization(const covariance_factorization &) = delete;
+  covariance_factorization &
+  operator=(const covariance_factorization &) = delete;
+
+  //! Returns the covariance matrix
+  const matrix_type &sigma() const { return sigma_; }
+
+  //! Returns the lower Cholesky factor, L, of the covariance matrix
+  const matrix_type &lower() const {
+    std::call_once(lower_once_,
+                   [this]() { lower_ = Backend::cholesky(sigma_); });
+    return lower_;
+  }
+
+  //! Returns the inverse of the lower Cholesky factor
+  const matrix_type &inv_lower() const {
+    std::call_once(inv_lower_once_,
+                   [this]() { inv_lower_ = Backend::inverse_lower(lower()); });
+    return inv_lower_;
+  }
+
+  //! Returns the inverse of the covariance matrix, i.e., the precision matrix
+  const matrix_type &inverse() const {
+    std::call_once(inv_once_,
+                   [this]() { inv_ = Backend::crossprod(inv_lower()); });
+    return inv_;
+  }
+
+  //! Returns the log-determinant of the covariance matrix
+  RealType log_det() const {
+    std::call_once(log_det_once_,
+                   [this]() { log_det_ = Backend::log_det_lower(lower()); });
+    return log_det_;
+  }
+};
+
+} // namespace detail
+
+} // namespace baaraan
+
+#endif // BAARAAN_COVARIANCE_FACTORIZATION_H
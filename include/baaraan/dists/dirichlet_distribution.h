@@ -0,0 +1,432 @@
+///
+/// @file
+/// This file contains the implementation of the Dirichlet random
+/// distribution.
+///
+
+#ifndef BAARAAN_DIRICHLET_DISTRIBUTION_H
+#define BAARAAN_DIRICHLET_DISTRIBUTION_H
+
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "compiled.h"
+#include "snapshot.h"
+
+namespace baaraan {
+
+///
+/// @brief      Dirichlet Random Distribution
+///
+/// A draw normalizes independent Gamma(alpha_i, 1) variates, generated by
+/// the squeeze and rejection method of Marsaglia and Tsang, whose constants
+/// are computed once per component by the param_type. Concentrations below
+/// 1 are boosted, i.e., Gamma(a + 1) U^(1/a), and, to avoid underflows,
+/// their draws are normalized in log-space.
+///
+/// The kernel runs over the whole k x n block of a batch at once. It draws
+/// a normal proposal for every pending variate, then a uniform for every
+/// one, runs the squeeze and log tests over the block, away from the
+/// engine, and only redraws the rejected variates in the next round. The
+/// boosting uniforms follow, column by column. A batch therefore takes its
+/// values from the engine in a different order than n single draws, and
+/// differs from them, although both follow the same distribution.
+///
+/// @tparam     RealType  Indicates the type of return values
+///
+/// @ingroup    MultivariateDistribution
+///
+template <class RealType = double> class dirichlet_distribution {
+public:
+  // types
+  typedef arma::Mat<RealType> matrix_type;
+  typedef arma::Col<RealType> vector_type;
+
+  ///
+  /// @brief      Dirichlet Distribution Parameter Type
+  ///
+  class param_type {
+    vector_type alpha_;
+
+    // Marsaglia-Tsang constants, d = a - 1/3 and c = 1 / sqrt(9 d), of the
+    // possibly boosted concentrations, and 1 / a of the boosted ones
+    vector_type d_;
+    vector_type c_;
+    vector_type inv_boost_;
+
+    bool log_space_;
+
+    param_type() : log_space_(false) {}
+
+    void init() {
+      const size_t k = alpha_.n_elem;
+      d_.set_size(k);
+      c_.set_size(k);
+      inv_boost_.zeros(k);
+      log_space_ = false;
+
+      for (size_t i = 0; i < k; ++i) {
+        RealType a = alpha_[i];
+        if (a < 1) {
+          inv_boost_[i] = 1 / a;
+          log_space_ = true;
+          a += 1;
+        }
+        const RealType d = a - RealType(1) / 3;
+        d_[i] = d;
+        c_[i] = 1 / std::sqrt(9 * d);
+      }
+    }
+
+  public:
+    typedef dirichlet_distribution distribution_type;
+
+    explicit param_type(vector_type alpha) : alpha_(std::move(alpha)) {
+      if (alpha_.is_empty())
+        throw std::length_error("Concentrations vector is empty.");
+
+      if (arma::any(alpha_ <= 0))
+        throw std::logic_error("Concentrations should be positive.");
+
+      init();
+    }
+
+    size_t dims() const { return alpha_.n_elem; }
+
+    const vector_type &alpha() const { return alpha_; }
+
+    const vector_type &d() const { return d_; }
+
+    const vector_type &c() const { return c_; }
+
+    const vector_type &inv_boost() const { return inv_boost_; }
+
+    //! Returns true if some of the concentrations are below 1
+    bool log_space() const { return log_space_; }
+
+    //! Writes the concentrations to a binary snapshot
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_vector(os, alpha_);
+    }
+
+    //! Reads the concentrations written by save()
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      param_type p;
+      snapshot::read_vector(is, p.alpha_);
+
+      if (p.alpha_.is_empty() || arma::any(p.alpha_ <= 0))
+        is.setstate(std::ios_base::failbit);
+
+      if (is)
+        p.init();
+
+      return p;
+    }
+
+    friend bool operator==(const param_type &x, const param_type &y) {
+      return x.alpha_.n_elem == y.alpha_.n_elem &&
+             arma::approx_equal(x.alpha_, y.alpha_, "absdiff", 0.001);
+    }
+
+    friend bool operator!=(const param_type &x, const param_type &y) {
+      return !(x == y);
+    }
+  };
+
+  //! Normals and uniforms of the gamma kernel, and its pending proposals
+  struct context_type {
+    std::normal_distribution<RealType> norm; // N~(0, 1)
+    std::uniform_real_distribution<RealType> uniform;
+
+    std::vector<size_t> pending;
+    std::vector<RealType> x;
+    std::vector<RealType> u;
+
+    void reset() {
+      norm.reset();
+      uniform.reset();
+    }
+  };
+
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+  //! Fills the k x n block at res with Gamma(d_i + 1/3, 1) variates
+  template <class URNG>
+  static void gamma(URNG &g, context_type &ctx, const param_type &p,
+                    RealType *res, size_t n);
+
+  //! Draws n Dirichlet vectors into the columns of the k x n block at x
+  template <class URNG>
+  static void draw(URNG &g, context_type &ctx, const param_type &p,
+                   RealType *x, size_t n);
+
+public:
+  // constructor and reset functions
+
+  ///
+  /// @brief      Constructs an instance of the Dirichlet distribution by
+  /// accepting an instance of dirichlet_distribution::param_type.
+  ///
+  /// @param[in]  p
+  ///
+  explicit dirichlet_distribution(const param_type &p) : p_(p) {}
+
+  ///
+  /// @brief      Constructs an instance of the Dirichlet distribution by
+  /// accepting its concentration parameters.
+  ///
+  /// @param[in]  alpha  The concentration parameters
+  ///
+  explicit dirichlet_distribution(vector_type alpha)
+      : p_(param_type(std::move(alpha))) {}
+
+  void reset() { ctx_.reset(); };
+
+  // generating functions
+  template <class URNG> vector_type operator()(URNG &g) {
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> vector_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // batch generation
+  template <class URNG> matrix_type operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                         size_t n) const;
+
+  // property functions
+
+  vector_type alpha() const { return p_.alpha(); }
+
+  //! Returns the mean vector, alpha / sum(alpha)
+  vector_type means() const { return p_.alpha() / arma::accu(p_.alpha()); }
+
+  param_type param() const { return p_; }
+
+  void param(const param_type &p) { p_ = p; }
+
+  vector_type min() const { return vector_type(p_.dims(), arma::fill::zeros); }
+
+  vector_type max() const { return vector_type(p_.dims(), arma::fill::ones); }
+
+  friend bool operator==(const dirichlet_distribution &x,
+                         const dirichlet_distribution &y) {
+    return x.p_ == y.p_;
+  }
+
+  friend bool operator!=(const dirichlet_distribution &x,
+                         const dirichlet_distribution &y) {
+    return !(x == y);
+  }
+
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
+  template <class charT, class traits>
+  friend std::basic_ostream<charT, traits> &
+  operator<<(std::basic_ostream<charT, traits> &os,
+             const dirichlet_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::dirichlet, sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.norm);
+    snapshot::write_state(os, x.ctx_.uniform);
+    return os;
+  }
+
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
+  template <class charT, class traits>
+  friend std::basic_istream<charT, traits> &
+  operator>>(std::basic_istream<charT, traits> &is,
+             dirichlet_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::dirichlet,
+                               sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::normal_distribution<RealType> norm;
+    std::uniform_real_distribution<RealType> uniform;
+    snapshot::read_state(is, norm);
+    snapshot::read_state(is, uniform);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.norm = norm;
+      x.ctx_.uniform = uniform;
+    }
+    return is;
+  }
+};
+
+///
+/// A proposal, x, is rejected if v = (1 + c x)^3 is not positive. Unlike in
+/// the original method, it then also costs a uniform, but the accepted
+/// variates keep the same distribution.
+///
+template <class RealType>
+template <class URNG>
+void dirichlet_distribution<RealType>::gamma(URNG &g, context_type &ctx,
+                                             const param_type &p,
+                                             RealType *res, size_t n) {
+  const size_t k = p.dims();
+  const RealType *d = p.d().memptr();
+  const RealType *c = p.c().memptr();
+
+  std::vector<size_t> &pending = ctx.pending;
+  pending.resize(k * n);
+  for (size_t e = 0; e < k * n; ++e)
+    pending[e] = e;
+
+  while (!pending.empty()) {
+    const size_t m = pending.size();
+    ctx.x.resize(m);
+    ctx.u.resize(m);
+
+    for (size_t t = 0; t < m; ++t)
+      ctx.x[t] = ctx.norm(g);
+    for (size_t t = 0; t < m; ++t)
+      ctx.u[t] = ctx.uniform(g);
+
+    // squeeze and log tests, the rejected variates are kept pending
+    size_t left = 0;
+    for (size_t t = 0; t < m; ++t) {
+      const size_t e = pending[t], i = e % k;
+      const RealType x = ctx.x[t], u = ctx.u[t], x2 = x * x;
+
+      RealType v = 1 + c[i] * x;
+      v = v * v * v;
+
+      if (v > 0 && (u < 1 - RealType(0.0331) * x2 * x2 ||
+                    std::log(u) < x2 / 2 + d[i] * (1 - v + std::log(v))))
+        res[e] = d[i] * v;
+      else
+        pending[left++] = e;
+    }
+    pending.resize(left);
+  }
+}
+
+template <class RealType>
+template <class URNG>
+void dirichlet_distribution<RealType>::draw(URNG &g, context_type &ctx,
+                                            const param_type &p, RealType *x,
+                                            size_t n) {
+  const size_t k = p.dims();
+  const RealType *inv_boost = p.inv_boost().memptr();
+
+  gamma(g, ctx, p, x, n);
+
+  if (!p.log_space()) {
+    for (RealType *col = x; col != x + k * n; col += k) {
+      RealType sum = 0;
+      for (size_t i = 0; i < k; ++i)
+        sum += col[i];
+
+      for (size_t i = 0; i < k; ++i)
+        col[i] /= sum;
+    }
+
+    return;
+  }
+
+  // log Gamma(a) = log Gamma(a + 1) + log(U) / a, for the boosted a < 1,
+  // with U drawn from (0, 1] so that its log stays finite
+  for (RealType *col = x; col != x + k * n; col += k) {
+    RealType max = -std::numeric_limits<RealType>::infinity();
+    for (size_t i = 0; i < k; ++i) {
+      col[i] = std::log(col[i]);
+      if (inv_boost[i] > 0)
+        col[i] += std::log(1 - ctx.uniform(g)) * inv_boost[i];
+      max = std::max(max, col[i]);
+    }
+
+    RealType sum = 0;
+    for (size_t i = 0; i < k; ++i) {
+      col[i] = std::exp(col[i] - max);
+      sum += col[i];
+    }
+
+    for (size_t i = 0; i < k; ++i)
+      col[i] /= sum;
+  }
+}
+
+template <class RealType>
+template <class URNG>
+typename dirichlet_distribution<RealType>::vector_type
+dirichlet_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const dirichlet_distribution<RealType>::param_type &p) const {
+
+  vector_type res(p.dims());
+  draw(g, ctx, p, res.memptr(), 1);
+
+  return res;
+}
+
+template <class RealType>
+template <class URNG>
+typename dirichlet_distribution<RealType>::matrix_type
+dirichlet_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const dirichlet_distribution<RealType>::param_type &p, size_t n) const {
+
+  matrix_type res(p.dims(), n);
+  draw(g, ctx, p, res.memptr(), n);
+
+  return res;
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_DIRICHLET_INSTANCES(EXT)                                      \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT, dirichlet_distribution)  \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             dirichlet_distribution, vector_type)             \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_BATCH_INSTANCE, EXT,                     \
+                             dirichlet_distribution, matrix_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_DIRICHLET_INSTANCES(extern)
+#endif
+
+} // namespace baaraan
+
+#endif // BAARAAN_DIRICHLET_DISTRIBUTION_H
@@ -0,0 +1,41 @@
+///
+/// @file
+/// This file forward declares all the distributions, without including
+/// Armadillo or Boost. It can be used in headers that only pass the
+/// distributions around by reference or pointer.
+///
+/// @note       The default template arguments are given by the full
+/// definitions, so all arguments have to be spelled out when only this header
+/// is included, e.g., `mvnorm_distribution<double, Backend>`.
+///
+
+#ifndef BAARAAN_FWD_H
+#define BAARAAN_FWD_H
+
+namespace baaraan {
+
+namespace linalg {
+template <class RealType> struct armadillo_backend;
+template <class RealType> struct blas_backend;
+template <class RealType> struct eigen_backend;
+} // namespace linalg
+
+template <class RealType> class circulant_mvnorm_distribution;
+template <class RealType> class dirichlet_distribution;
+template <class RealType> class gaussian_copula_distribution;
+template <class RealType> class gmrf_distribution;
+template <class RealType> class inverse_wishart_distribution;
+template <class RealType> class matrix_normal_distribution;
+template <class RealType> class mixture_mvnorm_distribution;
+template <class RealType, class Backend> class mv_t_distribution;
+template <class IntType> class multinomial_distribution;
+template <class RealType, class Backend> class mvnorm_distribution;
+template <class RealType, class Backend> class rectified_mvnorm_distribution;
+template <class RealType> class rectified_normal_distribution;
+template <class RealType> class truncated_mvnorm_distribution;
+template <class RealType> class truncated_normal_distribution;
+template <class RealType> class wishart_distribution;
+
+} // namespace baaraan
+
+#endif // BAARAAN_FWD_H
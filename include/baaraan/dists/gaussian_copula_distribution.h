@@ -0,0 +1,417 @@
+///
+/// @file
+/// This file contains the implementation of the Gaussian copula random
+/// distribution, i.e., a correlated normal draw whose coordinates are mapped
+/// to arbitrary marginal distributions through their quantile functions.
+///
+
+#ifndef BAARAAN_GAUSSIAN_COPULA_DISTRIBUTION_H
+#define BAARAAN_GAUSSIAN_COPULA_DISTRIBUTION_H
+
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mvnorm_distribution.h"
+#include "compiled.h"
+
+namespace baaraan {
+
+namespace detail {
+
+//! Wraps a quantile function, i.e., any callable taking a probability
+template <class RealType, class Quantile>
+auto as_quantile(Quantile q, int)
+    -> decltype(RealType(q(RealType())), std::function<RealType(RealType)>()) {
+  return q;
+}
+
+//! Wraps the quantile of a distribution found by ADL, e.g., any Boost.Math
+//! distribution
+template <class RealType, class Distribution>
+auto as_quantile(Distribution d, long)
+    -> decltype(RealType(quantile(d, RealType())),
+                std::function<RealType(RealType)>()) {
+  return [d](RealType u) { return RealType(quantile(d, u)); };
+}
+
+} // namespace detail
+
+///
+/// @brief      Gaussian Copula Random Distribution
+///
+/// A draw is z ~ N(0, R), for the correlation matrix R, with every coordinate
+/// mapped to its marginal as x_i = F_i^{-1}(Phi(z_i)). The marginals are
+/// given by Boost.Math distributions, or any callable returning the quantile
+/// of a probability.
+///
+/// Batches draw the whole d x n normal block first, correlate it with a
+/// single matrix product, and then map the contiguous scores of every
+/// dimension at once, through the same normal CDF kernel as single draws.
+/// Expensive quantiles can be tabulated instead, see marginal_type.
+///
+/// @code
+/// typedef gaussian_copula_distribution<>::marginal_type marginal;
+/// gaussian_copula_distribution<> copula{
+///     corr, {boost::math::gamma_distribution<>(2, 1),
+///            marginal(boost::math::beta_distribution<>(2, 5), 512),
+///            [](double u) { return std::floor(10 * u); }}};
+/// arma::mat sample = copula(gen, 1000);
+/// @endcode
+///
+/// @note       The marginals are arbitrary callables, so unlike the other
+/// distributions, the Gaussian copula has no binary snapshot.
+///
+/// @tparam     RealType  Indicates the type of return values
+///
+/// @ingroup    MultivariateDistribution
+///
+template <class RealType = double> class gaussian_copula_distribution {
+public:
+  // types
+  typedef arma::Mat<RealType> matrix_type;
+  typedef arma::Col<RealType> vector_type;
+  typedef std::function<RealType(RealType)> quantile_type;
+
+  ///
+  /// @brief      Marginal Distribution of a Dimension
+  ///
+  /// Maps the normal scores of its dimension to the marginal, either by
+  /// evaluating the quantile of their CDF, or, if it has been tabulated, by
+  /// linear interpolation between `points` values of the quantile at
+  /// equidistant normal scores on [-8, 8]. Scores outside that range fall
+  /// back to the exact quantile.
+  ///
+  /// @note       Tabulation is meant for continuous marginals, since it
+  /// interpolates between the steps of a discrete quantile.
+  ///
+  class marginal_type {
+    quantile_type quantile_;
+
+    std::vector<RealType> table_;
+
+    static constexpr RealType z_max = 8;
+
+    void tabulate(size_t points) {
+      if (points < 2)
+        return;
+
+      table_.resize(points);
+      const RealType h = 2 * z_max / (points - 1);
+      for (size_t k = 0; k < points; ++k)
+        table_[k] = quantile_(cdf(-z_max + k * h));
+    }
+
+  public:
+    ///
+    /// @brief      Constructs a marginal from a quantile function, or a
+    /// distribution with a `quantile(d, u)` overload.
+    ///
+    /// @param[in]  m       The quantile function, or the distribution
+    /// @param[in]  points  The number of tabulated values, 0 always evaluates
+    /// the quantile
+    ///
+    template <class Marginal,
+              class = std::enable_if_t<
+                  !std::is_same<std::decay_t<Marginal>, marginal_type>::value>,
+              class = decltype(detail::as_quantile<RealType>(
+                  std::declval<Marginal>(), 0))>
+    marginal_type(Marginal m, size_t points = 0)
+        : quantile_(detail::as_quantile<RealType>(std::move(m), 0)) {
+      tabulate(points);
+    }
+
+    //! Writes the normal CDF of the n scores at z to u, which may alias z,
+    //! kept strictly inside (0, 1), so that the quantiles stay finite
+    static void cdf(const RealType *z, RealType *u, size_t n) {
+      const RealType scale = -1 / std::sqrt(RealType(2));
+      const RealType lo = lowest_prob(), hi = highest_prob();
+
+      for (size_t k = 0; k < n; ++k)
+        u[k] = std::min(std::max(std::erfc(z[k] * scale) / 2, lo), hi);
+    }
+
+    //! Returns the normal CDF of z, through the same kernel
+    static RealType cdf(RealType z) {
+      RealType u;
+      cdf(&z, &u, 1);
+      return u;
+    }
+
+    static RealType lowest_prob() {
+      return std::numeric_limits<RealType>::min();
+    }
+
+    static RealType highest_prob() {
+      return 1 - std::numeric_limits<RealType>::epsilon() / 2;
+    }
+
+    const quantile_type &quantile() const { return quantile_; }
+
+    bool tabulated() const { return !table_.empty(); }
+
+    //! Returns the value of the marginal at the normal score z
+    RealType from_normal(RealType z) const {
+      if (tabulated()) {
+        const RealType last = RealType(table_.size() - 1);
+        const RealType t = (z + z_max) * last / (2 * z_max);
+        if (t >= 0 && t < last) {
+          const size_t k = size_t(t);
+          return table_[k] + (t - k) * (table_[k + 1] - table_[k]);
+        }
+      }
+      return quantile_(cdf(z));
+    }
+
+    //! Maps the n contiguous normal scores at z to the marginal, in place
+    void from_normal(RealType *z, size_t n) const {
+      if (tabulated()) {
+        for (size_t k = 0; k < n; ++k)
+          z[k] = from_normal(z[k]);
+        return;
+      }
+
+      cdf(z, z, n);
+      for (size_t k = 0; k < n; ++k)
+        z[k] = quantile_(z[k]);
+    }
+  };
+
+  ///
+  /// @brief      Gaussian Copula Distribution Parameter Type
+  ///
+  /// The correlation matrix is held by a mvnorm_distribution::param_type,
+  /// whose factorization is shared between copies, as are the marginals.
+  ///
+  class param_type {
+    typename mvnorm_distribution<RealType>::param_type norm_p_;
+
+    std::shared_ptr<const std::vector<marginal_type>> marginals_;
+
+  public:
+    typedef gaussian_copula_distribution distribution_type;
+
+    explicit param_type(matrix_type corr, std::vector<marginal_type> marginals)
+        : norm_p_(vector_type(corr.n_rows, arma::fill::zeros), corr) {
+
+      if (marginals.size() != corr.n_rows)
+        throw std::length_error(
+            "Number of marginals does not match the correlation matrix.");
+
+      if (arma::any(arma::abs(corr.diag() - 1) > 1e-8))
+        throw std::logic_error("Correlation matrix should have a unit "
+                               "diagonal.");
+
+      marginals_ = std::make_shared<const std::vector<marginal_type>>(
+          std::move(marginals));
+    }
+
+    //! Returns the dimension of the distribution
+    size_t dims() const { return norm_p_.dims(); }
+
+    //! Returns the correlation matrix
+    const matrix_type &corr() const { return norm_p_.sigma(); }
+
+    //! Returns the lower Cholesky factor of the correlation matrix
+    const matrix_type &corr_lower() const { return norm_p_.covs_lower(); }
+
+    const std::vector<marginal_type> &marginals() const { return *marginals_; }
+
+    //! Returns the parameters of the underlying normal distribution
+    const typename mvnorm_distribution<RealType>::param_type &
+    normal_param() const {
+      return norm_p_;
+    }
+
+    //! Marginals cannot be compared, so they are only equal if they are
+    //! shared, i.e., between copies of a param_type
+    friend bool operator==(const param_type &x, const param_type &y) {
+      return x.marginals_ == y.marginals_ && x.norm_p_ == y.norm_p_;
+    }
+
+    friend bool operator!=(const param_type &x, const param_type &y) {
+      return !(x == y);
+    }
+  };
+
+  //! Latent normal draws, and the buffer of a single correlated vector
+  struct context_type {
+    std::normal_distribution<RealType> norm; // N~(0, 1)
+    vector_type v;
+
+    void reset() { norm.reset(); }
+  };
+
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+public:
+  // constructor and reset functions
+
+  ///
+  /// @brief      Constructs an instance of the Gaussian copula distribution
+  /// by accepting an instance of gaussian_copula_distribution::param_type.
+  ///
+  /// @param[in]  p
+  ///
+  explicit gaussian_copula_distribution(const param_type &p) : p_(p) {}
+
+  ///
+  /// @brief      Constructs an instance of the Gaussian copula distribution
+  /// by accepting its correlation matrix and the marginals of its dimensions.
+  ///
+  /// @param[in]  corr       The correlation matrix
+  /// @param[in]  marginals  The marginal distributions
+  ///
+  explicit gaussian_copula_distribution(matrix_type corr,
+                                        std::vector<marginal_type> marginals)
+      : p_(param_type(std::move(corr), std::move(marginals))) {}
+
+  void reset() { ctx_.reset(); };
+
+  // generating functions
+  template <class URNG> vector_type operator()(URNG &g) {
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> vector_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // batch generation
+  template <class URNG> matrix_type operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                         size_t n) const;
+
+  // property functions
+
+  matrix_type corr() const { return p_.corr(); }
+
+  const std::vector<marginal_type> &marginals() const {
+    return p_.marginals();
+  }
+
+  param_type param() const { return p_; }
+
+  void param(const param_type &p) { p_ = p; }
+
+  //! Returns the quantiles of the lowest probability the sampler evaluates
+  vector_type min() const {
+    vector_type res(p_.dims());
+    for (size_t i = 0; i < p_.dims(); ++i)
+      res[i] = p_.marginals()[i].quantile()(marginal_type::lowest_prob());
+    return res;
+  }
+
+  //! Returns the quantiles of the highest probability the sampler evaluates
+  vector_type max() const {
+    vector_type res(p_.dims());
+    for (size_t i = 0; i < p_.dims(); ++i)
+      res[i] = p_.marginals()[i].quantile()(marginal_type::highest_prob());
+    return res;
+  }
+
+  friend bool operator==(const gaussian_copula_distribution &x,
+                         const gaussian_copula_distribution &y) {
+    return x.p_ == y.p_;
+  }
+
+  friend bool operator!=(const gaussian_copula_distribution &x,
+                         const gaussian_copula_distribution &y) {
+    return !(x == y);
+  }
+};
+
+template <class RealType>
+template <class URNG>
+typename gaussian_copula_distribution<RealType>::vector_type
+gaussian_copula_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const gaussian_copula_distribution<RealType>::param_type &p) const {
+
+  ctx.v.set_size(p.dims());
+  ctx.v.imbue([&]() { return ctx.norm(g); });
+
+  vector_type res = p.corr_lower() * ctx.v;
+  for (size_t i = 0; i < p.dims(); ++i)
+    p.marginals()[i].from_normal(res.memptr() + i, 1);
+
+  return res;
+}
+
+///
+/// The correlated scores are transposed, so that every dimension is mapped
+/// over a contiguous column by a single call of marginal_type::from_normal(),
+/// the same as single draws use, and a batch equals n single draws.
+///
+template <class RealType>
+template <class URNG>
+typename gaussian_copula_distribution<RealType>::matrix_type
+gaussian_copula_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const gaussian_copula_distribution<RealType>::param_type &p,
+    size_t n) const {
+
+  matrix_type z(p.dims(), n);
+  z.imbue([&]() { return ctx.norm(g); });
+
+  matrix_type res = p.corr_lower() * z;
+  arma::inplace_trans(res);
+
+  for (size_t i = 0; i < p.dims(); ++i)
+    p.marginals()[i].from_normal(res.colptr(i), n);
+
+  arma::inplace_trans(res);
+  return res;
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_GAUSSIAN_COPULA_INSTANCES(EXT)                                \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT,                          \
+                        gaussian_copula_distribution)                         \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             gaussian_copula_distribution, vector_type)       \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_BATCH_INSTANCE, EXT,                     \
+                             gaussian_copula_distribution, matrix_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_GAUSSIAN_COPULA_INSTANCES(extern)
+#endif
+
+} // namespace baaraan
+
+#endif // BAARAAN_GAUSSIAN_COPULA_DISTRIBUTION_H
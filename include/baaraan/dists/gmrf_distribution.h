@@ -0,0 +1,525 @@
+///
+/// @file
+/// This file contains the implementation of the Gaussian Markov random
+/// field distribution, i.e., a multivariate normal distribution given by a
+/// sparse precision matrix.
+///
+
+#ifndef BAARAAN_GMRF_DISTRIBUTION_H
+#define BAARAAN_GMRF_DISTRIBUTION_H
+
+#include <armadillo>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "sparse_cholesky.h"
+#include "compiled.h"
+#include "snapshot.h"
+
+namespace baaraan {
+
+///
+/// @brief      Gaussian Markov Random Field Distribution
+///
+/// A multivariate normal distribution, N(mu, inv(Q)), given by its sparse
+/// precision matrix Q. Q is factorized once, as P Q P' = L L', see
+/// detail::sparse_cholesky, and a draw solves L' y = z for z ~ N(0, I), so
+/// that x = mu + P' y. Neither the covariance matrix nor any other dense
+/// d x d matrix is ever formed, and memory and the cost of a draw scale
+/// with the non-zeros of L.
+///
+/// @code
+/// arma::sp_mat q = ...; // e.g., the precision of an intrinsic CAR model
+/// gmrf_distribution<> gmrf{arma::vec(q.n_rows, arma::fill::zeros), q};
+/// arma::mat sample = gmrf(gen, 100);
+/// @endcode
+///
+/// @tparam     RealType  Indicates the type of return values
+///
+/// @ingroup    MultivariateDistribution
+///
+template <class RealType = double> class gmrf_distribution {
+public:
+  // types
+  typedef arma::Mat<RealType> matrix_type;
+  typedef arma::Col<RealType> vector_type;
+  typedef arma::SpMat<RealType> sp_matrix_type;
+
+  ///
+  /// @brief      Parameters of the Gaussian Markov Random Field
+  ///
+  /// The factorization of the precision matrix is shared between copies.
+  ///
+  class param_type {
+    typedef detail::sparse_cholesky<RealType> factor_type;
+
+    vector_type means_;
+    sp_matrix_type precision_;
+
+    std::shared_ptr<const factor_type> f_;
+
+    param_type() {}
+
+    static std::shared_ptr<const factor_type>
+    factorize(const sp_matrix_type &q) {
+      if (!q.is_square() || !q.is_symmetric())
+        throw std::logic_error(
+            "Precision matrix is not square or symmetrical.");
+
+      std::vector<size_t> cp(q.n_cols + 1, 0), ri;
+      std::vector<RealType> vx;
+      ri.reserve(q.n_nonzero);
+      vx.reserve(q.n_nonzero);
+
+      for (auto it = q.begin(); it != q.end(); ++it) {
+        ++cp[it.col() + 1];
+        ri.push_back(it.row());
+        vx.push_back(*it);
+      }
+      for (size_t j = 0; j < q.n_cols; ++j)
+        cp[j + 1] += cp[j];
+
+      return std::make_shared<const factor_type>(q.n_rows, cp, ri, vx);
+    }
+
+    //! Returns inv(Q) b, from the factorization of Q
+    static vector_type solve(const factor_type &f, const vector_type &b) {
+      const std::vector<size_t> &perm = f.perm();
+
+      vector_type y(b.n_elem);
+      for (size_t k = 0; k < perm.size(); ++k)
+        y[k] = b[perm[k]];
+
+      f.solve_lower(y.memptr());
+      f.solve_upper(y.memptr());
+
+      vector_type x(b.n_elem);
+      for (size_t k = 0; k < perm.size(); ++k)
+        x[perm[k]] = y[k];
+
+      return x;
+    }
+
+  public:
+    typedef gmrf_distribution distribution_type;
+
+    ///
+    /// @brief      Constructs the parameters from the mean vector and the
+    /// precision matrix, which is factorized immediately.
+    ///
+    /// @throw      std::runtime_error if the precision matrix is not positive
+    /// definite
+    ///
+    explicit param_type(vector_type means, sp_matrix_type precision)
+        : means_(std::move(means)), precision_(std::move(precision)) {
+
+      if (precision_.n_rows != means_.n_elem)
+        throw std::length_error("Precision matrix has the wrong dimension.");
+
+      f_ = factorize(precision_);
+    }
+
+    ///
+    /// @brief      Constructs the parameters from the canonical form,
+    /// N_C(b, Q), i.e., the mean vector is inv(Q) b.
+    ///
+    static param_type canonical(sp_matrix_type precision, vector_type b) {
+      if (precision.n_rows != b.n_elem)
+        throw std::length_error("Precision matrix has the wrong dimension.");
+
+      param_type p;
+      p.f_ = factorize(precision);
+      p.means_ = solve(*p.f_, b);
+      p.precision_ = std::move(precision);
+      return p;
+    }
+
+    size_t dims() const { return means_.n_elem; }
+
+    const vector_type &means() const { return means_; }
+
+    const sp_matrix_type &precision() const { return precision_; }
+
+    //! Returns the number of non-zeros of the Cholesky factor
+    size_t factor_nnz() const { return f_->nnz(); }
+
+    //! Returns the ordering of the Cholesky factor, see
+    //! detail::sparse_cholesky
+    const std::vector<size_t> &perm() const { return f_->perm(); }
+
+    //! Returns the log-determinant of the precision matrix
+    RealType log_det() const { return f_->log_det(); }
+
+    const detail::sparse_cholesky<RealType> &factor() const { return *f_; }
+
+    ///
+    /// @brief      Returns the distribution of the unobserved coordinates,
+    /// given the values of the others.
+    ///
+    /// In the canonical form, x_A | x_B ~ N_C(b_A - Q_AB x_B, Q_AA), with
+    /// b = Q mu, so the conditional precision is a sparse submatrix of Q,
+    /// which is factorized in turn.
+    ///
+    /// @param[in]  given   The indices of the observed coordinates
+    /// @param[in]  values  Their observed values
+    ///
+    /// @return     The parameters over the remaining coordinates, in
+    /// increasing order of their indices
+    ///
+    param_type condition(const std::vector<size_t> &given,
+                         const vector_type &values) const;
+
+    //! Writes the parameters, and the Cholesky factor, to a binary snapshot
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_vector(os, means_);
+      snapshot::write_sparse(os, precision_);
+      f_->save(os);
+    }
+
+    ///
+    /// @brief      Reads the parameters written by save(), without
+    /// refactorizing the precision matrix.
+    ///
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      param_type p;
+      snapshot::read_vector(is, p.means_);
+      snapshot::read_sparse(is, p.precision_);
+
+      if (p.precision_.n_rows != p.means_.n_elem ||
+          p.precision_.n_cols != p.means_.n_elem)
+        is.setstate(std::ios_base::failbit);
+
+      if (is)
+        p.f_ = factor_type::load(is, p.means_.n_elem);
+
+      return p;
+    }
+
+    friend bool operator==(const param_type &x, const param_type &y) {
+      if (x.f_ == y.f_)
+        return true;
+
+      return x.dims() == y.dims() &&
+             arma::approx_equal(x.means_, y.means_, "absdiff", 0.001) &&
+             sp_matrix_type(arma::abs(x.precision_ - y.precision_)).max() <=
+                 0.001;
+    }
+
+    friend bool operator!=(const param_type &x, const param_type &y) {
+      return !(x == y);
+    }
+  };
+
+  //! Standard normals, one row per draw, overwritten by the sparse solve
+  struct context_type {
+    std::normal_distribution<RealType> norm; // N~(0, 1)
+    matrix_type y;
+
+    void reset() { norm.reset(); }
+  };
+
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+public:
+  // constructor and reset functions
+
+  ///
+  /// @brief      Constructs an instance of the GMRF distribution by accepting
+  /// an instance of gmrf_distribution::param_type.
+  ///
+  /// @param[in]  p
+  ///
+  explicit gmrf_distribution(const param_type &p) : p_(p) {}
+
+  ///
+  /// @brief      Constructs an instance of the GMRF distribution by accepting
+  /// its mean vector and its sparse precision matrix.
+  ///
+  /// @param[in]  means      The mean vector
+  /// @param[in]  precision  The precision matrix
+  ///
+  explicit gmrf_distribution(vector_type means, sp_matrix_type precision)
+      : p_(param_type(std::move(means), std::move(precision))) {}
+
+  void reset() { ctx_.reset(); };
+
+  // generating functions
+  template <class URNG> vector_type operator()(URNG &g) {
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> vector_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // batch generation
+  template <class URNG> matrix_type operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                         size_t n) const;
+
+  // density functions
+
+  ///
+  /// @brief      Evaluates the log-density of each column of x
+  ///
+  /// @param[in]  x     A d x m matrix of points
+  ///
+  /// @return     A vector of m log-densities
+  ///
+  vector_type log_pdf(const matrix_type &x) const { return log_pdf(x, p_); }
+
+  vector_type log_pdf(const matrix_type &x, const param_type &p) const;
+
+  // property functions
+
+  vector_type means() const { return p_.means(); }
+
+  sp_matrix_type precision() const { return p_.precision(); }
+
+  param_type param() const { return p_; }
+
+  void param(const param_type &p) { p_ = p; }
+
+  vector_type min() const {
+    return vector_type(p_.dims()).fill(
+        -std::numeric_limits<RealType>::infinity());
+  }
+
+  vector_type max() const {
+    return vector_type(p_.dims()).fill(
+        +std::numeric_limits<RealType>::infinity());
+  }
+
+  friend bool operator==(const gmrf_distribution &x,
+                         const gmrf_distribution &y) {
+    return x.p_ == y.p_;
+  }
+
+  friend bool operator!=(const gmrf_distribution &x,
+                         const gmrf_distribution &y) {
+    return !(x == y);
+  }
+
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
+  template <class charT, class traits>
+  friend std::basic_ostream<charT, traits> &
+  operator<<(std::basic_ostream<charT, traits> &os,
+             const gmrf_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::gmrf, sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.norm);
+    return os;
+  }
+
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
+  template <class charT, class traits>
+  friend std::basic_istream<charT, traits> &
+  operator>>(std::basic_istream<charT, traits> &is, gmrf_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::gmrf, sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::normal_distribution<RealType> norm;
+    snapshot::read_state(is, norm);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.norm = norm;
+    }
+    return is;
+  }
+};
+
+template <class RealType>
+typename gmrf_distribution<RealType>::param_type
+gmrf_distribution<RealType>::param_type::condition(
+    const std::vector<size_t> &given, const vector_type &values) const {
+
+  const size_t d = dims();
+  if (given.empty() || given.size() >= d)
+    throw std::logic_error(
+        "Given indices should be a non-empty, proper subset.");
+
+  if (values.n_elem != given.size())
+    throw std::length_error("Observed values have the wrong dimension.");
+
+  // position of every coordinate among the free ones, or none if given
+  const size_t none = std::numeric_limits<size_t>::max();
+  std::vector<size_t> pos(d, 0);
+  vector_type x(d, arma::fill::zeros);
+  for (size_t i = 0; i < given.size(); ++i) {
+    if (given[i] >= d)
+      throw std::out_of_range("Given index is out of range.");
+    if (pos[given[i]] == none)
+      throw std::logic_error("Given indices should be unique.");
+    pos[given[i]] = none;
+    x[given[i]] = values[i];
+  }
+
+  size_t n_free = 0;
+  for (size_t i = 0; i < d; ++i)
+    if (pos[i] != none)
+      pos[i] = n_free++;
+
+  // b_A - Q_AB x_B, with b = Q mu, and the non-zeros of Q_AA
+  const vector_type b = precision_ * means_;
+  vector_type b_free(n_free);
+  for (size_t i = 0; i < d; ++i)
+    if (pos[i] != none)
+      b_free[pos[i]] = b[i];
+
+  std::vector<arma::uword> rows, cols;
+  std::vector<RealType> vals;
+  for (auto it = precision_.begin(); it != precision_.end(); ++it) {
+    const size_t r = pos[it.row()], c = pos[it.col()];
+    if (r == none)
+      continue;
+
+    if (c == none) {
+      b_free[r] -= (*it) * x[it.col()];
+    } else {
+      rows.push_back(r);
+      cols.push_back(c);
+      vals.push_back(*it);
+    }
+  }
+
+  arma::umat locations(2, vals.size());
+  for (size_t k = 0; k < vals.size(); ++k) {
+    locations(0, k) = rows[k];
+    locations(1, k) = cols[k];
+  }
+
+  return canonical(sp_matrix_type(locations, vector_type(vals), n_free,
+                                  n_free),
+                   std::move(b_free));
+}
+
+template <class RealType>
+template <class URNG>
+typename gmrf_distribution<RealType>::vector_type
+gmrf_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const gmrf_distribution<RealType>::param_type &p) const {
+
+  const size_t d = p.dims();
+  const std::vector<size_t> &perm = p.perm();
+
+  ctx.y.set_size(1, d);
+  ctx.y.imbue([&]() { return ctx.norm(g); });
+  p.factor().solve_upper(ctx.y.memptr());
+
+  vector_type res(d);
+  for (size_t k = 0; k < d; ++k)
+    res[perm[k]] = ctx.y[k] + p.means()[perm[k]];
+
+  return res;
+}
+
+///
+/// All right-hand sides are solved in a single pass over the factor. They
+/// are held in the rows of an n x d matrix, so that every non-zero of the
+/// factor updates a contiguous column of n values. The normal values are
+/// drawn in the same order as n single draws.
+///
+template <class RealType>
+template <class URNG>
+typename gmrf_distribution<RealType>::matrix_type
+gmrf_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const gmrf_distribution<RealType>::param_type &p, size_t n) const {
+
+  const size_t d = p.dims();
+  const std::vector<size_t> &perm = p.perm();
+
+  ctx.y.set_size(n, d);
+  for (size_t s = 0; s < n; ++s)
+    for (size_t k = 0; k < d; ++k)
+      ctx.y(s, k) = ctx.norm(g);
+
+  p.factor().solve_upper(ctx.y.memptr(), n);
+
+  matrix_type res(d, n);
+  for (size_t k = 0; k < d; ++k) {
+    const RealType mu = p.means()[perm[k]];
+    for (size_t s = 0; s < n; ++s)
+      res(perm[k], s) = ctx.y(s, k) + mu;
+  }
+
+  return res;
+}
+
+template <class RealType>
+typename gmrf_distribution<RealType>::vector_type
+gmrf_distribution<RealType>::log_pdf(
+    const matrix_type &x,
+    const gmrf_distribution<RealType>::param_type &p) const {
+
+  if (x.n_rows != p.dims())
+    throw std::length_error("Points have the wrong dimension.");
+
+  matrix_type diff = x;
+  diff.each_col() -= p.means();
+
+  // (x - mu)' Q (x - mu), with a sparse product
+  const matrix_type qdiff = p.precision() * diff;
+
+  const RealType log_2pi = std::log(2 * arma::datum::pi);
+  return arma::trans(0.5 * (p.log_det() - p.dims() * log_2pi) -
+                     0.5 * arma::sum(diff % qdiff, 0));
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_GMRF_INSTANCES(EXT)                                           \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT, gmrf_distribution)       \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             gmrf_distribution, vector_type)                  \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_BATCH_INSTANCE, EXT, gmrf_distribution,  \
+                             matrix_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_GMRF_INSTANCES(extern)
+#endif
+
+} // namespace baaraan
+
+#endif // BAARAAN_GMRF_DISTRIBUTION_H
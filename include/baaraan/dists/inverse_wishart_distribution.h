@@ -0,0 +1,309 @@
+///
+/// @file
+/// This file contains the implementation of the inverse Wishart random
+/// distribution.
+///
+
+#ifndef BAARAAN_INVERSE_WISHART_DISTRIBUTION_H
+#define BAARAAN_INVERSE_WISHART_DISTRIBUTION_H
+
+#include <armadillo>
+#include <iostream>
+#include <random>
+
+#include "compiled.h"
+#include "snapshot.h"
+#include "wishart_distribution.h"
+
+namespace baaraan {
+
+///
+/// @brief      Inverse Wishart Random Distribution
+///
+/// If X ~ IW(dof, Psi), then inv(X) ~ W(dof, inv(Psi)). With Psi = L L' and A
+/// the Bartlett factor, a draw is X = M M' where M' = inv(A) L', which only
+/// needs a triangular solve, and the cached Cholesky factor of Psi, i.e.,
+/// neither Psi nor the drawn matrix is ever explicitly inverted.
+///
+/// @tparam     RealType  Indicates the type of return values
+///
+/// @ingroup    MultivariateDistribution
+///
+template <class RealType = double> class inverse_wishart_distribution {
+public:
+  // types
+  typedef arma::Mat<RealType> matrix_type;
+  typedef arma::Cube<RealType> cube_type;
+
+  ///
+  /// @brief      Inverse Wishart Distribution Parameter Type
+  ///
+  class param_type {
+    size_t dims_;
+    RealType dof_;
+    matrix_type scale_;
+
+    matrix_type scale_lower_;
+
+    param_type() : dims_(0), dof_(0) {}
+
+  public:
+    typedef inverse_wishart_distribution distribution_type;
+
+    explicit param_type(RealType dof, matrix_type scale)
+        : dims_(scale.n_rows), dof_(dof), scale_(scale) {
+
+      if (!scale.is_symmetric() || !scale.is_square())
+        throw std::logic_error("Scale matrix is not square or symmetrical.");
+
+      if (dof <= dims_ - 1.)
+        throw std::logic_error(
+            "Degrees of freedom should be greater than dims - 1.");
+
+      scale_lower_ = arma::chol(scale_, "lower");
+    }
+
+    //! Returns the dimension of the distribution
+    size_t dims() const { return dims_; }
+
+    //! Returns the degrees of freedom
+    RealType dof() const { return dof_; }
+
+    //! Returns the scale matrix
+    const matrix_type &scale() const { return scale_; }
+
+    //! Returns the lower Cholesky factor of the scale matrix
+    const matrix_type &scale_lower() const { return scale_lower_; }
+
+    //! Writes the parameters, and the Cholesky factor, to a binary snapshot
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_pod(os, dof_);
+      snapshot::write_matrix(os, scale_);
+      snapshot::write_matrix(os, scale_lower_);
+    }
+
+    //! Reads the parameters written by save(), without refactorization
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      param_type p;
+      snapshot::read_pod(is, p.dof_);
+      snapshot::read_matrix(is, p.scale_);
+      snapshot::read_matrix(is, p.scale_lower_);
+
+      p.dims_ = p.scale_.n_rows;
+      if (p.scale_.n_cols != p.dims_ || p.scale_lower_.n_rows != p.dims_ ||
+          p.scale_lower_.n_cols != p.dims_ || !(p.dof_ > p.dims_ - 1.))
+        is.setstate(std::ios_base::failbit);
+      else
+        snapshot::check_lower(is, p.scale_lower_.memptr(), p.dims_);
+
+      return p;
+    }
+
+    friend bool operator==(const param_type &x, const param_type &y) {
+      return x.dof_ == y.dof_ &&
+             arma::approx_equal(x.scale_, y.scale_, "absdiff", 0.001);
+    }
+
+    friend bool operator!=(const param_type &x, const param_type &y) {
+      return !(x == y);
+    }
+  };
+
+  //! Bartlett normals and chi-squares, and the lower factor they fill
+  struct context_type {
+    std::normal_distribution<RealType> norm; // N~(0, 1)
+    std::chi_squared_distribution<RealType> chisq;
+    matrix_type a;
+
+    void reset() {
+      norm.reset();
+      chisq.reset();
+    }
+  };
+
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+public:
+  // constructor and reset functions
+
+  ///
+  /// @brief      Constructs an instance of the inverse Wishart distribution by
+  /// accepting an instance of inverse_wishart_distribution::param_type.
+  ///
+  /// @param[in]  p
+  ///
+  explicit inverse_wishart_distribution(const param_type &p) : p_(p) {}
+
+  ///
+  /// @brief      Constructs an instance of the inverse Wishart distribution by
+  /// accepting its degrees of freedom and scale matrix.
+  ///
+  /// @param[in]  dof    The degrees of freedom, should be greater than d - 1
+  /// @param[in]  scale  The scale matrix
+  ///
+  explicit inverse_wishart_distribution(RealType dof, matrix_type scale)
+      : p_(param_type(dof, scale)) {}
+
+  void reset() { ctx_.reset(); };
+
+  // generating functions
+  template <class URNG> matrix_type operator()(URNG &g) {
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> matrix_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // batch generation
+  template <class URNG> cube_type operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  cube_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  cube_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  cube_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                       size_t n) const;
+
+  // property functions
+
+  size_t dims() const { return p_.dims(); }
+
+  RealType dof() const { return p_.dof(); }
+
+  matrix_type scale() const { return p_.scale(); }
+
+  //! Returns the mean of the distribution, only defined for dof > d + 1
+  matrix_type mean() const { return p_.scale() / (p_.dof() - p_.dims() - 1.); }
+
+  param_type param() const { return p_; }
+
+  void param(const param_type &p) { p_ = p; }
+
+  friend bool operator==(const inverse_wishart_distribution &x,
+                         const inverse_wishart_distribution &y) {
+    return x.p_ == y.p_;
+  }
+
+  friend bool operator!=(const inverse_wishart_distribution &x,
+                         const inverse_wishart_distribution &y) {
+    return !(x == y);
+  }
+
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
+  template <class charT, class traits>
+  friend std::basic_ostream<charT, traits> &
+  operator<<(std::basic_ostream<charT, traits> &os,
+             const inverse_wishart_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::inverse_wishart,
+                           sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.norm);
+    snapshot::write_state(os, x.ctx_.chisq);
+    return os;
+  }
+
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
+  template <class charT, class traits>
+  friend std::basic_istream<charT, traits> &
+  operator>>(std::basic_istream<charT, traits> &is,
+             inverse_wishart_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::inverse_wishart,
+                               sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::normal_distribution<RealType> norm;
+    std::chi_squared_distribution<RealType> chisq;
+    snapshot::read_state(is, norm);
+    snapshot::read_state(is, chisq);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.norm = norm;
+      x.ctx_.chisq = chisq;
+    }
+    return is;
+  }
+};
+
+template <class RealType>
+template <class URNG>
+typename inverse_wishart_distribution<RealType>::matrix_type
+inverse_wishart_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const inverse_wishart_distribution<RealType>::param_type &p) const {
+
+  detail::bartlett_factor(ctx.a, p.dims(), p.dof(), g, ctx.norm, ctx.chisq);
+
+  matrix_type mt = arma::solve(arma::trimatl(ctx.a), p.scale_lower().t());
+  return mt.t() * mt;
+}
+
+template <class RealType>
+template <class URNG>
+typename inverse_wishart_distribution<RealType>::cube_type
+inverse_wishart_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const inverse_wishart_distribution<RealType>::param_type &p,
+    size_t n) const {
+
+  cube_type res(p.dims(), p.dims(), n);
+  matrix_type lt = p.scale_lower().t();
+  matrix_type mt;
+
+  for (size_t k = 0; k < n; ++k) {
+    detail::bartlett_factor(ctx.a, p.dims(), p.dof(), g, ctx.norm, ctx.chisq);
+
+    mt = arma::solve(arma::trimatl(ctx.a), lt);
+    res.slice(k) = mt.t() * mt;
+  }
+
+  return res;
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_INVERSE_WISHART_INSTANCES(EXT)                                \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT,                          \
+                        inverse_wishart_distribution)                         \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             inverse_wishart_distribution, matrix_type)       \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_BATCH_INSTANCE, EXT,                     \
+                             inverse_wishart_distribution, cube_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_INVERSE_WISHART_INSTANCES(extern)
+#endif
+
+} // namespace baaraan
+
+#endif // BAARAAN_INVERSE_WISHART_DISTRIBUTION_H
@@ -0,0 +1,358 @@
+///
+/// @file
+/// This file contains the implementation of the matrix normal random
+/// distribution.
+///
+
+#ifndef BAARAAN_MATRIX_NORMAL_DISTRIBUTION_H
+#define BAARAAN_MATRIX_NORMAL_DISTRIBUTION_H
+
+#include <armadillo>
+#include <iostream>
+#include <random>
+
+#include "compiled.h"
+#include "snapshot.h"
+
+namespace baaraan {
+
+///
+/// @brief      Matrix Normal Random Distribution
+///
+/// Draws n x p random matrices X ~ MN(M, U, V), i.e., vec(X) ~ N(vec(M), V ⊗
+/// U). Instead of factorizing the np x np Kronecker covariance, U and V are
+/// factorized separately, and every draw is computed as M + L_U Z L_V' where Z
+/// is an n x p matrix of standard normal values.
+///
+/// @tparam     RealType  Indicates the type of return values
+///
+/// @ingroup    MultivariateDistribution
+///
+template <class RealType = double> class matrix_normal_distribution {
+public:
+  // types
+  typedef arma::Mat<RealType> matrix_type;
+  typedef arma::Cube<RealType> cube_type;
+
+  ///
+  /// @brief      Matrix Normal Distribution Parameter Type
+  ///
+  class param_type {
+    size_t n_rows_;
+    size_t n_cols_;
+    matrix_type means_;
+    matrix_type row_sigma_;
+    matrix_type col_sigma_;
+
+    matrix_type row_lower_;
+    matrix_type col_lower_;
+
+    void factorize_covariance() {
+      row_lower_ = arma::chol(row_sigma_, "lower");
+      col_lower_ = arma::chol(col_sigma_, "lower");
+    }
+
+    param_type() : n_rows_(0), n_cols_(0) {}
+
+  public:
+    typedef matrix_normal_distribution distribution_type;
+
+    explicit param_type(matrix_type means, matrix_type row_sigma,
+                        matrix_type col_sigma)
+        : n_rows_(means.n_rows), n_cols_(means.n_cols), means_(means),
+          row_sigma_(row_sigma), col_sigma_(col_sigma) {
+
+      if (row_sigma.n_rows != n_rows_)
+        throw std::length_error(
+            "Row covariance matrix has the wrong dimension.");
+
+      if (col_sigma.n_rows != n_cols_)
+        throw std::length_error(
+            "Column covariance matrix has the wrong dimension.");
+
+      if (!row_sigma.is_symmetric() || !row_sigma.is_square())
+        throw std::logic_error(
+            "Row covariance matrix is not square or symmetrical.");
+
+      if (!col_sigma.is_symmetric() || !col_sigma.is_square())
+        throw std::logic_error(
+            "Column covariance matrix is not square or symmetrical.");
+
+      factorize_covariance();
+    }
+
+    //! Returns the number of rows of every draw
+    size_t n_rows() const { return n_rows_; }
+
+    //! Returns the number of columns of every draw
+    size_t n_cols() const { return n_cols_; }
+
+    //! Returns the mean matrix of the distribution
+    const matrix_type &means() const { return means_; }
+
+    //! Returns the among-row covariance matrix, U
+    const matrix_type &row_sigma() const { return row_sigma_; }
+
+    //! Returns the among-column covariance matrix, V
+    const matrix_type &col_sigma() const { return col_sigma_; }
+
+    //! Returns the lower Cholesky factor of the row covariance matrix
+    const matrix_type &row_lower() const { return row_lower_; }
+
+    //! Returns the lower Cholesky factor of the column covariance matrix
+    const matrix_type &col_lower() const { return col_lower_; }
+
+    //! Writes the parameters, and both Cholesky factors, to a binary snapshot
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_matrix(os, means_);
+      snapshot::write_matrix(os, row_sigma_);
+      snapshot::write_matrix(os, col_sigma_);
+      snapshot::write_matrix(os, row_lower_);
+      snapshot::write_matrix(os, col_lower_);
+    }
+
+    //! Reads the parameters written by save(), without refactorization
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      param_type p;
+      snapshot::read_matrix(is, p.means_);
+      snapshot::read_matrix(is, p.row_sigma_);
+      snapshot::read_matrix(is, p.col_sigma_);
+      snapshot::read_matrix(is, p.row_lower_);
+      snapshot::read_matrix(is, p.col_lower_);
+
+      p.n_rows_ = p.means_.n_rows;
+      p.n_cols_ = p.means_.n_cols;
+      if (p.row_sigma_.n_rows != p.n_rows_ ||
+          p.row_sigma_.n_cols != p.n_rows_ ||
+          p.col_sigma_.n_rows != p.n_cols_ ||
+          p.col_sigma_.n_cols != p.n_cols_ ||
+          p.row_lower_.n_rows != p.n_rows_ ||
+          p.row_lower_.n_cols != p.n_rows_ ||
+          p.col_lower_.n_rows != p.n_cols_ || p.col_lower_.n_cols != p.n_cols_)
+        is.setstate(std::ios_base::failbit);
+      else if (snapshot::check_lower(is, p.row_lower_.memptr(), p.n_rows_))
+        snapshot::check_lower(is, p.col_lower_.memptr(), p.n_cols_);
+
+      return p;
+    }
+
+    friend bool operator==(const param_type &x, const param_type &y) {
+      return arma::approx_equal(x.means_, y.means_, "absdiff", 0.001) &&
+             arma::approx_equal(x.row_sigma_, y.row_sigma_, "absdiff",
+                                0.001) &&
+             arma::approx_equal(x.col_sigma_, y.col_sigma_, "absdiff", 0.001);
+    }
+
+    friend bool operator!=(const param_type &x, const param_type &y) {
+      return !(x == y);
+    }
+  };
+
+  //! Standard normals, and the matrix of them mixed by both factors
+  struct context_type {
+    std::normal_distribution<RealType> norm; // N~(0, 1)
+    matrix_type z;
+
+    void reset() { norm.reset(); }
+  };
+
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+public:
+  // constructor and reset functions
+
+  ///
+  /// @brief      Constructs an instance of the matrix normal distribution by
+  /// accepting an instance of matrix_normal_distribution::param_type.
+  ///
+  /// @param[in]  p
+  ///
+  explicit matrix_normal_distribution(const param_type &p) : p_(p) {}
+
+  ///
+  /// @brief      Constructs an instance of the matrix normal distribution by
+  /// accepting its mean matrix, and its row and column covariance matrices.
+  ///
+  /// @param[in]  means      The n x p mean matrix
+  /// @param[in]  row_sigma  The n x n among-row covariance matrix
+  /// @param[in]  col_sigma  The p x p among-column covariance matrix
+  ///
+  explicit matrix_normal_distribution(matrix_type means, matrix_type row_sigma,
+                                      matrix_type col_sigma)
+      : p_(param_type(means, row_sigma, col_sigma)) {}
+
+  void reset() { ctx_.reset(); };
+
+  // generating functions
+  template <class URNG> matrix_type operator()(URNG &g) {
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> matrix_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // batch generation
+  template <class URNG> cube_type operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  cube_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  cube_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  cube_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                       size_t n) const;
+
+  // property functions
+
+  matrix_type means() const { return p_.means(); }
+
+  matrix_type row_sigma() const { return p_.row_sigma(); }
+
+  matrix_type col_sigma() const { return p_.col_sigma(); }
+
+  param_type param() const { return p_; }
+
+  void param(const param_type &p) { p_ = p; }
+
+public:
+  matrix_type min() const {
+    return matrix_type(p_.n_rows(), p_.n_cols())
+        .fill(-std::numeric_limits<RealType>::infinity());
+  }
+
+  matrix_type max() const {
+    return matrix_type(p_.n_rows(), p_.n_cols())
+        .fill(+std::numeric_limits<RealType>::infinity());
+  }
+
+  friend bool operator==(const matrix_normal_distribution &x,
+                         const matrix_normal_distribution &y) {
+    return x.p_ == y.p_;
+  }
+
+  friend bool operator!=(const matrix_normal_distribution &x,
+                         const matrix_normal_distribution &y) {
+    return !(x == y);
+  }
+
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
+  template <class charT, class traits>
+  friend std::basic_ostream<charT, traits> &
+  operator<<(std::basic_ostream<charT, traits> &os,
+             const matrix_normal_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::matrix_normal, sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.norm);
+    return os;
+  }
+
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
+  template <class charT, class traits>
+  friend std::basic_istream<charT, traits> &
+  operator>>(std::basic_istream<charT, traits> &is,
+             matrix_normal_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::matrix_normal,
+                               sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::normal_distribution<RealType> norm;
+    snapshot::read_state(is, norm);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.norm = norm;
+    }
+    return is;
+  }
+};
+
+template <class RealType>
+template <class URNG>
+typename matrix_normal_distribution<RealType>::matrix_type
+matrix_normal_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const matrix_normal_distribution<RealType>::param_type &p) const {
+
+  ctx.z.set_size(p.n_rows(), p.n_cols());
+  ctx.z.imbue([&]() { return ctx.norm(g); });
+
+  return p.row_lower() * ctx.z * p.col_lower().t() + p.means();
+}
+
+///
+/// The left factor is applied to all draws at once by viewing the n x p x N
+/// cube as a single n x pN matrix, and only the right factor is applied slice
+/// by slice.
+///
+template <class RealType>
+template <class URNG>
+typename matrix_normal_distribution<RealType>::cube_type
+matrix_normal_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const matrix_normal_distribution<RealType>::param_type &p, size_t n) const {
+
+  cube_type res(p.n_rows(), p.n_cols(), n);
+
+  ctx.z.set_size(p.n_rows(), p.n_cols() * n);
+  ctx.z.imbue([&]() { return ctx.norm(g); });
+
+  // res viewed as an n x pN matrix, sharing its memory
+  matrix_type lz(res.memptr(), p.n_rows(), p.n_cols() * n, false, true);
+  lz = p.row_lower() * ctx.z;
+
+  const matrix_type col_upper = p.col_lower().t();
+  matrix_type tmp;
+  for (size_t k = 0; k < n; ++k) {
+    tmp = res.slice(k) * col_upper;
+    res.slice(k) = tmp + p.means();
+  }
+
+  return res;
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_MATRIX_NORMAL_INSTANCES(EXT)                                  \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT,                          \
+                        matrix_normal_distribution)                           \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             matrix_normal_distribution, matrix_type)         \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_BATCH_INSTANCE, EXT,                     \
+                             matrix_normal_distribution, cube_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_MATRIX_NORMAL_INSTANCES(extern)
+#endif
+
+} // namespace baaraan
+
+#endif // BAARAAN_MATRIX_NORMAL_DISTRIBUTION_H
@@ -0,0 +1,505 @@
+///
+/// @file
+/// This file contains the implementation of the finite mixture of
+/// multivariate normal random distributions, a.k.a, Gaussian mixture.
+///
+
+#ifndef BAARAAN_MIXTURE_MVNORM_DISTRIBUTION_H
+#define BAARAAN_MIXTURE_MVNORM_DISTRIBUTION_H
+
+#include <armadillo>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "mvnorm_distribution.h"
+#include "compiled.h"
+#include "snapshot.h"
+
+namespace baaraan {
+
+///
+/// @brief      Mixture of Multivariate Normal Random Distributions
+///
+/// Each draw first selects one of the K components with probability
+/// proportional to its weight, using Walker's alias table, i.e., O(1) per
+/// selection regardless of K, and then draws from the selected component
+/// using its precomputed Cholesky factor.
+///
+/// @tparam     RealType  Indicates the type of return values
+///
+/// @ingroup    MultivariateDistribution
+///
+template <class RealType = double> class mixture_mvnorm_distribution {
+public:
+  // types
+  typedef arma::Mat<RealType> matrix_type;
+  typedef arma::Col<RealType> vector_type;
+  typedef typename mvnorm_distribution<RealType>::param_type component_type;
+
+  ///
+  /// @brief      Mixture of Multivariate Normal Distribution Parameter Type
+  ///
+  class param_type {
+    size_t dims_;
+    vector_type weights_;
+    std::vector<component_type> comps_;
+
+    vector_type alias_prob_;
+    arma::uvec alias_idx_;
+
+    //! log(w_k) - 0.5 * (d * log(2pi) + log|Sigma_k|) of each component
+    vector_type log_consts_;
+
+    ///
+    /// Builds the alias table using Vose's variant of Walker's method.
+    ///
+    void build_alias_table() {
+      const size_t k = weights_.n_elem;
+
+      vector_type scaled =
+          weights_ * (static_cast<RealType>(k) / arma::accu(weights_));
+
+      alias_prob_.set_size(k);
+      alias_idx_.set_size(k);
+
+      std::vector<size_t> small, large;
+      small.reserve(k);
+      large.reserve(k);
+      for (size_t i = 0; i < k; ++i)
+        (scaled(i) < 1 ? small : large).push_back(i);
+
+      while (!small.empty() && !large.empty()) {
+        size_t s = small.back();
+        small.pop_back();
+        size_t l = large.back();
+        large.pop_back();
+
+        alias_prob_(s) = scaled(s);
+        alias_idx_(s) = l;
+
+        scaled(l) = (scaled(l) + scaled(s)) - 1;
+        (scaled(l) < 1 ? small : large).push_back(l);
+      }
+
+      // Whatever is left is (numerically) exactly one
+      for (size_t i : large) {
+        alias_prob_(i) = 1;
+        alias_idx_(i) = i;
+      }
+      for (size_t i : small) {
+        alias_prob_(i) = 1;
+        alias_idx_(i) = i;
+      }
+    }
+
+    void compute_log_consts() {
+      const RealType log_2pi = std::log(2 * arma::Datum<RealType>::pi);
+      const RealType total = arma::accu(weights_);
+
+      log_consts_.set_size(comps_.size());
+      for (size_t i = 0; i < comps_.size(); ++i) {
+        log_consts_(i) = std::log(weights_(i) / total) -
+                         0.5 * (dims_ * log_2pi + comps_[i].log_det());
+      }
+    }
+
+    param_type() : dims_(0) {}
+
+  public:
+    typedef mixture_mvnorm_distribution distribution_type;
+
+    explicit param_type(vector_type weights, std::vector<component_type> comps)
+        : weights_(weights), comps_(std::move(comps)) {
+
+      if (comps_.empty())
+        throw std::logic_error("Mixture should have at least one component.");
+
+      if (weights_.n_elem != comps_.size())
+        throw std::length_error(
+            "Number of weights and components does not match.");
+
+      if (weights_.min() < 0 || arma::accu(weights_) <= 0)
+        throw std::logic_error(
+            "Weights should be non-negative and not all zero.");
+
+      dims_ = comps_.front().dims();
+      for (const auto &c : comps_)
+        if (c.dims() != dims_)
+          throw std::length_error("Components have different dimensions.");
+
+      build_alias_table();
+      compute_log_consts();
+    }
+
+    //! Returns the dimension of the distribution
+    size_t dims() const { return dims_; }
+
+    //! Returns the number of mixture components
+    size_t n_components() const { return comps_.size(); }
+
+    //! Returns the (unnormalized) weights of the components
+    const vector_type &weights() const { return weights_; }
+
+    //! Returns the parameters of all components
+    const std::vector<component_type> &components() const { return comps_; }
+
+    //! Returns the parameters of the k-th component
+    const component_type &component(size_t k) const { return comps_[k]; }
+
+    const vector_type &log_consts() const { return log_consts_; }
+
+    ///
+    /// @brief      Maps a single U(0, 1) draw to a component index using the
+    /// alias table.
+    ///
+    /// @param[in]  u     A uniform value in [0, 1)
+    ///
+    size_t select(RealType u) const {
+      const size_t k = comps_.size();
+      RealType x = u * k;
+      size_t i = std::min(static_cast<size_t>(x), k - 1);
+      return (x - i) < alias_prob_(i) ? i : alias_idx_(i);
+    }
+
+    ///
+    /// @brief      Writes the weights, and the parameters and factorization
+    /// of every component, to a binary snapshot.
+    ///
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_vector(os, weights_);
+      snapshot::write_pod(os, static_cast<std::uint64_t>(comps_.size()));
+      for (const auto &c : comps_)
+        c.save(os);
+    }
+
+    ///
+    /// @brief      Reads the parameters written by save(). Only the alias
+    /// table is rebuilt, which is linear in the number of components.
+    ///
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      vector_type weights;
+      std::uint64_t k{0};
+      snapshot::read_vector(is, weights);
+      snapshot::read_pod(is, k);
+
+      std::vector<component_type> comps;
+      for (std::uint64_t i = 0; is && i < k; ++i)
+        comps.push_back(component_type::load(is));
+
+      if (!is || k == 0 || weights.n_elem != k) {
+        is.setstate(std::ios_base::failbit);
+        return param_type();
+      }
+
+      try {
+        return param_type(weights, std::move(comps));
+      } catch (const std::logic_error &) {
+        is.setstate(std::ios_base::failbit);
+        return param_type();
+      }
+    }
+
+    friend bool operator==(const param_type &x, const param_type &y) {
+      return arma::approx_equal(x.weights_, y.weights_, "absdiff", 0.001) &&
+             x.comps_ == y.comps_;
+    }
+
+    friend bool operator!=(const param_type &x, const param_type &y) {
+      return !(x == y);
+    }
+  };
+
+  //! Component selector uniform, and the normals of the chosen component
+  struct context_type {
+    std::normal_distribution<RealType> norm; // N~(0, 1)
+    std::uniform_real_distribution<RealType> uniform;
+    vector_type v;
+    matrix_type z;
+
+    void reset() {
+      norm.reset();
+      uniform.reset();
+    }
+  };
+
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+public:
+  // constructor and reset functions
+
+  ///
+  /// @brief      Constructs an instance of the mixture distribution by
+  /// accepting an instance of mixture_mvnorm_distribution::param_type.
+  ///
+  /// @param[in]  p
+  ///
+  explicit mixture_mvnorm_distribution(const param_type &p) : p_(p) {}
+
+  ///
+  /// @brief      Constructs an instance of the mixture distribution by
+  /// accepting the component weights and the parameters of each component.
+  ///
+  /// @param[in]  weights  The weights of the components, will be normalized
+  /// @param[in]  comps    The parameters of each multivariate normal component
+  ///
+  explicit mixture_mvnorm_distribution(vector_type weights,
+                                       std::vector<component_type> comps)
+      : p_(param_type(weights, std::move(comps))) {}
+
+  void reset() { ctx_.reset(); };
+
+  // generating functions
+  template <class URNG> vector_type operator()(URNG &g) {
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> vector_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // batch generation
+  template <class URNG> matrix_type operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                         size_t n) const;
+
+  // density functions
+
+  ///
+  /// @brief      Evaluates the log-density of each column of x
+  ///
+  /// @param[in]  x     A d x m matrix of points
+  ///
+  /// @return     A vector of m log-densities
+  ///
+  vector_type log_pdf(const matrix_type &x) const { return log_pdf(x, p_); }
+
+  vector_type log_pdf(const matrix_type &x, const param_type &p) const;
+
+  // property functions
+
+  size_t dims() const { return p_.dims(); }
+
+  size_t n_components() const { return p_.n_components(); }
+
+  vector_type weights() const { return p_.weights(); }
+
+  param_type param() const { return p_; }
+
+  void param(const param_type &p) { p_ = p; }
+
+public:
+  vector_type min() const {
+    return vector_type(p_.dims()).fill(
+        -std::numeric_limits<RealType>::infinity());
+  }
+
+  vector_type max() const {
+    return vector_type(p_.dims()).fill(
+        +std::numeric_limits<RealType>::infinity());
+  }
+
+  friend bool operator==(const mixture_mvnorm_distribution &x,
+                         const mixture_mvnorm_distribution &y) {
+    return x.p_ == y.p_;
+  }
+
+  friend bool operator!=(const mixture_mvnorm_distribution &x,
+                         const mixture_mvnorm_distribution &y) {
+    return !(x == y);
+  }
+
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
+  template <class charT, class traits>
+  friend std::basic_ostream<charT, traits> &
+  operator<<(std::basic_ostream<charT, traits> &os,
+             const mixture_mvnorm_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::mixture_mvnorm,
+                           sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.norm);
+    snapshot::write_state(os, x.ctx_.uniform);
+    return os;
+  }
+
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
+  template <class charT, class traits>
+  friend std::basic_istream<charT, traits> &
+  operator>>(std::basic_istream<charT, traits> &is,
+             mixture_mvnorm_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::mixture_mvnorm,
+                               sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::normal_distribution<RealType> norm;
+    std::uniform_real_distribution<RealType> uniform;
+    snapshot::read_state(is, norm);
+    snapshot::read_state(is, uniform);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.norm = norm;
+      x.ctx_.uniform = uniform;
+    }
+    return is;
+  }
+};
+
+template <class RealType>
+template <class URNG>
+typename mixture_mvnorm_distribution<RealType>::vector_type
+mixture_mvnorm_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const mixture_mvnorm_distribution<RealType>::param_type &p) const {
+
+  const component_type &c = p.component(p.select(ctx.uniform(g)));
+
+  ctx.v.set_size(p.dims());
+  ctx.v.imbue([&]() { return ctx.norm(g); });
+
+  return c.covs_lower() * ctx.v + c.means();
+}
+
+///
+/// Draws all component labels first, buckets the draws by component using a
+/// counting sort, and then generates each component's block with a single
+/// matrix product. Blocks are scattered back to the label positions so that
+/// the columns of the result remain exchangeable.
+///
+template <class RealType>
+template <class URNG>
+typename mixture_mvnorm_distribution<RealType>::matrix_type
+mixture_mvnorm_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx,
+    const mixture_mvnorm_distribution<RealType>::param_type &p,
+    size_t n) const {
+
+  const size_t k = p.n_components();
+
+  arma::uvec labels(n);
+  arma::uvec counts(k, arma::fill::zeros);
+  for (size_t j = 0; j < n; ++j) {
+    labels(j) = p.select(ctx.uniform(g));
+    ++counts(labels(j));
+  }
+
+  // counting sort of the sample indices by their component
+  arma::uvec offsets(k + 1);
+  offsets(0) = 0;
+  for (size_t i = 0; i < k; ++i)
+    offsets(i + 1) = offsets(i) + counts(i);
+
+  arma::uvec order(n);
+  arma::uvec next = offsets.head(k);
+  for (size_t j = 0; j < n; ++j)
+    order(next(labels(j))++) = j;
+
+  matrix_type res(p.dims(), n);
+  matrix_type &z = ctx.z;
+  matrix_type block;
+
+  for (size_t i = 0; i < k; ++i) {
+    if (counts(i) == 0)
+      continue;
+
+    const component_type &c = p.component(i);
+
+    z.set_size(p.dims(), counts(i));
+    z.imbue([&]() { return ctx.norm(g); });
+
+    block = c.covs_lower() * z;
+    block.each_col() += c.means();
+
+    res.cols(order.subvec(offsets(i), offsets(i + 1) - 1)) = block;
+  }
+
+  return res;
+}
+
+template <class RealType>
+typename mixture_mvnorm_distribution<RealType>::vector_type
+mixture_mvnorm_distribution<RealType>::log_pdf(
+    const matrix_type &x,
+    const mixture_mvnorm_distribution<RealType>::param_type &p) const {
+
+  if (x.n_rows != p.dims())
+    throw std::length_error("Points have the wrong dimension.");
+
+  const size_t k = p.n_components();
+
+  // log(w_k N(x | mu_k, Sigma_k)) for every component and point
+  matrix_type lk(k, x.n_cols);
+  lk.fill(-std::numeric_limits<RealType>::infinity());
+
+  matrix_type diff;
+  for (size_t i = 0; i < k; ++i) {
+    if (p.weights()(i) == 0)
+      continue;
+
+    const component_type &c = p.component(i);
+
+    diff = x;
+    diff.each_col() -= c.means();
+    matrix_type z = arma::solve(arma::trimatl(c.covs_lower()), diff);
+
+    lk.row(i) = p.log_consts()(i) - 0.5 * arma::sum(arma::square(z), 0);
+  }
+
+  // log-sum-exp over the components
+  arma::Row<RealType> mx = arma::max(lk, 0);
+  lk.each_row() -= mx;
+
+  return arma::trans(mx + arma::log(arma::sum(arma::exp(lk), 0)));
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_MIXTURE_MVNORM_INSTANCES(EXT)                                 \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT,                          \
+                        mixture_mvnorm_distribution)                          \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             mixture_mvnorm_distribution, vector_type)        \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_BATCH_INSTANCE, EXT,                     \
+                             mixture_mvnorm_distribution, matrix_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_MIXTURE_MVNORM_INSTANCES(extern)
+#endif
+
+} // namespace baaraan
+
+#endif // BAARAAN_MIXTURE_MVNORM_DISTRIBUTION_H
@@ -0,0 +1,413 @@
+///
+/// @file
+/// This file contains the implementation of the multinomial random
+/// distribution.
+///
+
+#ifndef BAARAAN_MULTINOMIAL_DISTRIBUTION_H
+#define BAARAAN_MULTINOMIAL_DISTRIBUTION_H
+
+#include <algorithm>
+#include <armadillo>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "compiled.h"
+#include "snapshot.h"
+
+namespace baaraan {
+
+///
+/// @brief      Multinomial Random Distribution
+///
+/// Counts of `trials` independent draws from `dims` categories. Two samplers
+/// are used, depending on which one is cheaper:
+///
+/// - If there are fewer trials than categories, every trial is drawn from
+///   an alias table, with a single uniform number, i.e., O(trials).
+/// - Otherwise, the counts are drawn as a sequence of conditional binomials,
+///   n_i ~ Bin(n - n_1 - ... - n_{i-1}, p_i / (p_i + ... + p_k)), visiting
+///   the categories in decreasing order of probability, and stopping as soon
+///   as all trials are allocated, i.e., O(dims) for any number of trials.
+///
+/// Both tables are built once by the param_type.
+///
+/// @tparam     IntType  Indicates the type of the counts
+///
+/// @ingroup    MultivariateDistribution
+///
+template <class IntType = int> class multinomial_distribution {
+public:
+  // types
+  typedef arma::Mat<IntType> matrix_type;
+  typedef arma::Col<IntType> vector_type;
+  typedef arma::Col<double> prob_type;
+
+  ///
+  /// @brief      Multinomial Distribution Parameter Type
+  ///
+  class param_type {
+    IntType trials_;
+    prob_type probs_;
+
+    // conditional binomial sampler, categories by decreasing probability,
+    // and their probabilities conditioned on not being any of the previous
+    std::vector<size_t> order_;
+    std::vector<double> cond_;
+
+    // alias sampler, Vose's method
+    std::vector<double> accept_;
+    std::vector<size_t> alias_;
+
+    param_type() : trials_(0) {}
+
+    void init() {
+      const size_t k = probs_.n_elem;
+
+      order_.resize(k);
+      for (size_t i = 0; i < k; ++i)
+        order_[i] = i;
+      std::stable_sort(order_.begin(), order_.end(), [&](size_t a, size_t b) {
+        return probs_[a] > probs_[b];
+      });
+
+      cond_.resize(k);
+      double tail = 0;
+      for (size_t i = k; i-- > 0;) {
+        const double pi = probs_[order_[i]];
+        tail += pi;
+        cond_[i] = tail > 0 ? std::min(1., pi / tail) : 0;
+      }
+
+      accept_.resize(k);
+      alias_.resize(k);
+      std::vector<size_t> small, large;
+      for (size_t i = 0; i < k; ++i) {
+        accept_[i] = probs_[i] * k;
+        alias_[i] = i;
+        (accept_[i] < 1 ? small : large).push_back(i);
+      }
+
+      while (!small.empty() && !large.empty()) {
+        const size_t s = small.back(), l = large.back();
+        small.pop_back();
+
+        alias_[s] = l;
+        accept_[l] -= 1 - accept_[s];
+        if (accept_[l] < 1) {
+          large.pop_back();
+          small.push_back(l);
+        }
+      }
+
+      // leftovers only differ from 1 by rounding errors
+      for (size_t i : small)
+        accept_[i] = 1;
+      for (size_t i : large)
+        accept_[i] = 1;
+    }
+
+  public:
+    typedef multinomial_distribution distribution_type;
+
+    ///
+    /// @brief      Constructs the parameters from the number of trials, and
+    /// the probabilities of the categories, which are normalized if they do
+    /// not sum to 1.
+    ///
+    explicit param_type(IntType trials, prob_type probs)
+        : trials_(trials), probs_(std::move(probs)) {
+      if (trials < 0)
+        throw std::logic_error("Number of trials should be non-negative.");
+
+      if (probs_.is_empty())
+        throw std::length_error("Probabilities vector is empty.");
+
+      if (arma::any(probs_ < 0) || arma::accu(probs_) <= 0)
+        throw std::logic_error(
+            "Probabilities should be non-negative, and not all zero.");
+
+      probs_ /= arma::accu(probs_);
+      init();
+    }
+
+    size_t dims() const { return probs_.n_elem; }
+
+    IntType trials() const { return trials_; }
+
+    const prob_type &probs() const { return probs_; }
+
+    const std::vector<size_t> &order() const { return order_; }
+
+    const std::vector<double> &cond() const { return cond_; }
+
+    const std::vector<double> &accept() const { return accept_; }
+
+    const std::vector<size_t> &alias() const { return alias_; }
+
+    //! Returns true if the alias sampler is cheaper than the conditional
+    //! binomials
+    bool use_alias() const { return size_t(trials_) < probs_.n_elem; }
+
+    //! Writes the parameters to a binary snapshot
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_pod(os, trials_);
+      snapshot::write_vector(os, probs_);
+    }
+
+    //! Reads the parameters written by save()
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      param_type p;
+      snapshot::read_pod(is, p.trials_);
+      snapshot::read_vector(is, p.probs_);
+
+      if (p.trials_ < 0 || p.probs_.is_empty() || arma::any(p.probs_ < 0) ||
+          arma::accu(p.probs_) <= 0)
+        is.setstate(std::ios_base::failbit);
+
+      if (is)
+        p.init();
+
+      return p;
+    }
+
+    friend bool operator==(const param_type &x, const param_type &y) {
+      return x.trials_ == y.trials_ && x.probs_.n_elem == y.probs_.n_elem &&
+             arma::approx_equal(x.probs_, y.probs_, "absdiff", 0.001);
+    }
+
+    friend bool operator!=(const param_type &x, const param_type &y) {
+      return !(x == y);
+    }
+  };
+
+  //! Alias table uniform, and the conditional binomials of large trials
+  struct context_type {
+    std::binomial_distribution<IntType> binom;
+    std::uniform_real_distribution<> uniform;
+
+    void reset() {
+      binom.reset();
+      uniform.reset();
+    }
+  };
+
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+  //! Draws a single vector of counts into x
+  template <class URNG>
+  static void draw(URNG &g, context_type &ctx, const param_type &p,
+                   IntType *x);
+
+public:
+  // constructor and reset functions
+
+  ///
+  /// @brief      Constructs an instance of the multinomial distribution by
+  /// accepting an instance of multinomial_distribution::param_type.
+  ///
+  /// @param[in]  p
+  ///
+  explicit multinomial_distribution(const param_type &p) : p_(p) {}
+
+  ///
+  /// @brief      Constructs an instance of the multinomial distribution by
+  /// accepting the number of trials, and the probabilities of the
+  /// categories.
+  ///
+  /// @param[in]  trials  The number of trials
+  /// @param[in]  probs   The probabilities, or weights, of the categories
+  ///
+  explicit multinomial_distribution(IntType trials, prob_type probs)
+      : p_(param_type(trials, std::move(probs))) {}
+
+  void reset() { ctx_.reset(); };
+
+  // generating functions
+  template <class URNG> vector_type operator()(URNG &g) {
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> vector_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // batch generation
+  template <class URNG> matrix_type operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                         size_t n) const;
+
+  // property functions
+
+  IntType trials() const { return p_.trials(); }
+
+  prob_type probs() const { return p_.probs(); }
+
+  param_type param() const { return p_; }
+
+  void param(const param_type &p) { p_ = p; }
+
+  vector_type min() const { return vector_type(p_.dims(), arma::fill::zeros); }
+
+  vector_type max() const { return vector_type(p_.dims()).fill(p_.trials()); }
+
+  friend bool operator==(const multinomial_distribution &x,
+                         const multinomial_distribution &y) {
+    return x.p_ == y.p_;
+  }
+
+  friend bool operator!=(const multinomial_distribution &x,
+                         const multinomial_distribution &y) {
+    return !(x == y);
+  }
+
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
+  template <class charT, class traits>
+  friend std::basic_ostream<charT, traits> &
+  operator<<(std::basic_ostream<charT, traits> &os,
+             const multinomial_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::multinomial, sizeof(IntType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.binom);
+    snapshot::write_state(os, x.ctx_.uniform);
+    return os;
+  }
+
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
+  template <class charT, class traits>
+  friend std::basic_istream<charT, traits> &
+  operator>>(std::basic_istream<charT, traits> &is,
+             multinomial_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::multinomial,
+                               sizeof(IntType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::binomial_distribution<IntType> binom;
+    std::uniform_real_distribution<> uniform;
+    snapshot::read_state(is, binom);
+    snapshot::read_state(is, uniform);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.binom = binom;
+      x.ctx_.uniform = uniform;
+    }
+    return is;
+  }
+};
+
+template <class IntType>
+template <class URNG>
+void multinomial_distribution<IntType>::draw(URNG &g, context_type &ctx,
+                                             const param_type &p,
+                                             IntType *x) {
+  const size_t k = p.dims();
+  std::fill(x, x + k, IntType(0));
+
+  if (p.use_alias()) {
+    const double *accept = p.accept().data();
+    const size_t *alias = p.alias().data();
+
+    for (IntType t = 0; t < p.trials(); ++t) {
+      const double u = ctx.uniform(g) * k;
+      const size_t i = std::min(size_t(u), k - 1);
+      ++x[u - i < accept[i] ? i : alias[i]];
+    }
+    return;
+  }
+
+  typedef typename std::binomial_distribution<IntType>::param_type binom_param;
+
+  const size_t *order = p.order().data();
+  const double *cond = p.cond().data();
+
+  IntType left = p.trials();
+  for (size_t i = 0; i + 1 < k && left > 0; ++i) {
+    const IntType c = ctx.binom(g, binom_param(left, cond[i]));
+    x[order[i]] = c;
+    left -= c;
+  }
+
+  // the last category takes whatever is left
+  if (left > 0)
+    x[order[k - 1]] = left;
+}
+
+template <class IntType>
+template <class URNG>
+typename multinomial_distribution<IntType>::vector_type
+multinomial_distribution<IntType>::operator()(
+    URNG &g, context_type &ctx,
+    const multinomial_distribution<IntType>::param_type &p) const {
+
+  vector_type res(p.dims());
+  draw(g, ctx, p, res.memptr());
+
+  return res;
+}
+
+template <class IntType>
+template <class URNG>
+typename multinomial_distribution<IntType>::matrix_type
+multinomial_distribution<IntType>::operator()(
+    URNG &g, context_type &ctx,
+    const multinomial_distribution<IntType>::param_type &p, size_t n) const {
+
+  matrix_type res(p.dims(), n);
+  for (size_t j = 0; j < n; ++j)
+    draw(g, ctx, p, res.colptr(j));
+
+  return res;
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_MULTINOMIAL_INSTANCES(EXT)                                    \
+  BAARAAN_FOR_EACH_INT(BAARAAN_CLASS_INSTANCE, EXT, multinomial_distribution) \
+  BAARAAN_FOR_EACH_INT_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                    \
+                            multinomial_distribution, vector_type)            \
+  BAARAAN_FOR_EACH_INT_URNG(BAARAAN_BATCH_INSTANCE, EXT,                      \
+                            multinomial_distribution, matrix_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_MULTINOMIAL_INSTANCES(extern)
+#endif
+
+} // namespace baaraan
+
+#endif // BAARAAN_MULTINOMIAL_DISTRIBUTION_H
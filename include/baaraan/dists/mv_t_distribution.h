@@ -11,80 +11,138 @@
 
 #include <armadillo>
 #include <iostream>
+#include <memory>
 #include <random>
 
+#include "../linalg/armadillo_backend.h"
+#include "covariance_factorization.h"
+#include "compiled.h"
+#include "snapshot.h"
+
 namespace baaraan {
 
 ///
 /// @brief      Multivariate t-student Random Distribution
 ///
+/// Like mvnorm_distribution, all matrix operations go through the Backend.
+///
 /// @tparam     RealType  Indicates the type of return values
+/// @tparam     Backend   The linear algebra backend, see armadillo_backend.h
 /// 
 /// @ingroup    MultivariateDistribution
 ///
-template <class RealType = double> class mv_t_distribution {
+template <class RealType = double,
+          class Backend = linalg::armadillo_backend<RealType>>
+class mv_t_distribution {
 public:
   // types
-  typedef arma::Mat<RealType> matrix_type;
-  typedef arma::Col<RealType> vector_type;
+  typedef Backend backend_type;
+  typedef typename Backend::matrix_type matrix_type;
+  typedef typename Backend::vector_type vector_type;
 
   ///
   /// @brief      Parameters of the Multivariate t-student Distribution
   ///
+  /// The scale matrix and its factorization are shared between copies, and
+  /// the factorization is only computed on its first use.
+  ///
   class param_type {
     size_t dims_;
-    int dof_;
+    double dof_;
     vector_type means_;
-    matrix_type sigma_;
 
-    arma::Mat<RealType> covs_lower_;
-    arma::Mat<RealType> inv_covs_lower_;
-    arma::Mat<RealType> inv_covs_;
+    typedef detail::covariance_factorization<RealType, Backend>
+        factorization_type;
 
-    void factorize_covariance() {
-      covs_lower_ = arma::chol(sigma_, "lower");
-      inv_covs_lower_ = arma::inv(arma::trimatl(covs_lower_));
-      inv_covs_ = inv_covs_lower_.t() * inv_covs_lower_;
-    }
+    std::shared_ptr<const factorization_type> f_;
 
-    matrix_type covs_lower() const { return covs_lower_; }
-    matrix_type inv_covs() const { return inv_covs_; }
+    param_type() : dims_(0), dof_(0) {}
 
   public:
     typedef mv_t_distribution distribution_type;
 
     explicit param_type(double dof, vector_type means, matrix_type sigma)
-        : dof_(dof), dims_(means.n_elem), means_(means), sigma_(sigma) {
+        : dims_(Backend::rows(means)), dof_(dof), means_(means) {
 
       if (dof <= 0)
         throw std::logic_error("degress of freedom should be positive.");
 
-      if (!means.is_colvec())
-        throw std::logic_error("Mean should be a column vector.");
-
-      if (sigma.n_rows != dims_)
+      if (Backend::rows(sigma) != dims_)
         throw std::length_error("Covariance matrix has the wrong dimension.");
 
-      if (!sigma.is_symmetric() || !sigma.is_square())
+      if (!Backend::is_symmetric(sigma))
         throw std::logic_error(
             "Covarinace matrix is not square or symmetrical.");
 
-      factorize_covariance();
+      f_ = std::make_shared<const factorization_type>(std::move(sigma));
     }
 
     size_t dims() const { return dims_; }
 
     double dof() const { return dof_; }
 
-    vector_type means() const { return means_; }
+    const vector_type &means() const { return means_; }
 
-    matrix_type sigma() const { return sigma_; }
+    const matrix_type &sigma() const { return f_->sigma(); }
 
+    //! Returns the lower Cholesky factor of the scale matrix
+    const matrix_type &covs_lower() const { return f_->lower(); }
+
+    //! Returns the inverse of the lower Cholesky factor
+    const matrix_type &inv_covs_lower() const { return f_->inv_lower(); }
+
+    //! Returns the inverse of the scale matrix
+    const matrix_type &inv_covs() const { return f_->inverse(); }
+
+    //! Returns the log-determinant of the scale matrix
+    RealType log_det() const { return f_->log_det(); }
+
+    ///
+    /// @brief      Writes the parameters, and the Cholesky factor, to a
+    /// binary snapshot.
+    ///
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_pod(os, dof_);
+      snapshot::write_dense<Backend>(os, means_);
+      snapshot::write_dense<Backend>(os, sigma());
+      snapshot::write_dense<Backend>(os, covs_lower());
+    }
+
+    ///
+    /// @brief      Reads the parameters written by save(), without
+    /// refactorizing the scale matrix.
+    ///
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      param_type p;
+      matrix_type sigma, lower;
+
+      snapshot::read_pod(is, p.dof_);
+      snapshot::read_dense<Backend>(is, p.means_);
+      snapshot::read_dense<Backend>(is, sigma);
+      snapshot::read_dense<Backend>(is, lower);
+
+      p.dims_ = Backend::rows(p.means_);
+      if (p.dof_ <= 0 || Backend::rows(sigma) != p.dims_ ||
+          Backend::cols(sigma) != p.dims_ || Backend::rows(lower) != p.dims_ ||
+          Backend::cols(lower) != p.dims_)
+        is.setstate(std::ios_base::failbit);
+      else
+        snapshot::check_lower(is, Backend::data(lower), p.dims_);
+
+      if (is)
+        p.f_ = std::make_shared<const factorization_type>(std::move(sigma),
+                                                          std::move(lower));
+
+      return p;
+    }
 
     friend bool operator==(const param_type &x, const param_type &y) {
       return x.dof_ == y.dof_ &&
-             arma::approx_equal(x.means_, y.means_, "absdiff", 0.001) &&
-             arma::approx_equal(x.sigma_, y.sigma_, "absdiff", 0.001);
+             Backend::approx_equal(x.means_, y.means_, 0.001) &&
+             (x.f_ == y.f_ ||
+              Backend::approx_equal(x.sigma(), y.sigma(), 0.001));
     }
 
     friend bool operator!=(const param_type &x, const param_type &y) {
@@ -92,12 +150,21 @@ public:
     }
   };
 
+  //! Normals of the latent mvnorm, and the chi-square of its mixing scale
+  struct context_type {
+    std::normal_distribution<> norm; // N~(0, 1)
+    std::chi_squared_distribution<> chisq;
+
+    void reset() {
+      norm.reset();
+      chisq.reset();
+    }
+  };
+
 private:
-  std::normal_distribution<> norm; // N~(0, 1)
-  std::chi_squared_distribution<> chisq;
+  context_type ctx_;
 
   param_type p_;
-  vector_type v_;
 
 public:
   // constructor and reset functions
@@ -122,21 +189,33 @@ public:
   explicit mv_t_distribution(double dof, vector_type means, matrix_type sigma)
       : p_(param_type(dof, means, sigma)) {}
 
-  void reset() { norm.reset(); };
+  void reset() { ctx_.reset(); };
 
   // generating functions
   template <class URNG> vector_type operator()(URNG &g) {
-    return (*this)(g, p_);
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> vector_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
   }
 
-  template <class URNG> vector_type operator()(URNG &g, const param_type &p);
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
 
   // property functions
   double dof() const { return p_.dof(); }
 
   vector_type means() const { return p_.means(); }
 
-  vector_type sigma() const { return p_.sigma(); }
+  matrix_type sigma() const { return p_.sigma(); }
 
   param_type param() const { return p_; }
 
@@ -145,13 +224,13 @@ public:
   }
 
   vector_type min() const {
-    return vector_type(p_.dims()).fill(
-        -std::numeric_limits<RealType>::infinity());
+    return Backend::constant(p_.dims(),
+                             -std::numeric_limits<RealType>::infinity());
   }
 
   vector_type max() const {
-    return vector_type(p_.dims()).fill(
-        +std::numeric_limits<RealType>::infinity());
+    return Backend::constant(p_.dims(),
+                             +std::numeric_limits<RealType>::infinity());
   }
 
   friend bool operator==(const mv_t_distribution &x,
@@ -164,32 +243,82 @@ public:
     return !(x == y);
   }
 
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
   template <class charT, class traits>
   friend std::basic_ostream<charT, traits> &
   operator<<(std::basic_ostream<charT, traits> &os,
-             const mv_t_distribution &means);
+             const mv_t_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::mv_t, sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.norm);
+    snapshot::write_state(os, x.ctx_.chisq);
+    return os;
+  }
 
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
   template <class charT, class traits>
   friend std::basic_istream<charT, traits> &
-  operator>>(std::basic_istream<charT, traits> &is, mv_t_distribution &means);
+  operator>>(std::basic_istream<charT, traits> &is, mv_t_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::mv_t, sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::normal_distribution<> norm;
+    std::chi_squared_distribution<> chisq;
+    snapshot::read_state(is, norm);
+    snapshot::read_state(is, chisq);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.norm = norm;
+      x.ctx_.chisq = chisq;
+    }
+    return is;
+  }
 };
 
-template <class RealType>
+template <class RealType, class Backend>
 template <class URNG>
-typename mv_t_distribution<RealType>::vector_type
-mv_t_distribution<RealType>::operator()(
-    URNG &g, const mv_t_distribution<RealType>::param_type &p) {
-
-  v_.resize(p_.dims(), 1);
-
-  v_.imbue([&]() { return norm(g); });
-  // if (p.is_covs_diagmat()) {
-  return arma::sqrt(p.dof() / p.covs_diag()) * v_ + p.means();
-  // } else {
-  //     return covs_lower * v_ + p.means();
-  // }
+typename mv_t_distribution<RealType, Backend>::vector_type
+mv_t_distribution<RealType, Backend>::operator()(URNG &g, context_type &ctx,
+                                                 const param_type &p) const {
+
+  vector_type x;
+  Backend::resize(x, p.dims());
+
+  RealType *z = Backend::data(x);
+  for (size_t i = 0; i < p.dims(); ++i)
+    z[i] = ctx.norm(g);
+
+  // X = mu + L z * sqrt(dof / W), W ~ chi^2(dof), with z scaled before the
+  // triangular product
+  typedef std::chi_squared_distribution<>::param_type chisq_param;
+  const RealType w = ctx.chisq(g, chisq_param(p.dof()));
+  const RealType s = std::sqrt(p.dof() / w);
+  for (size_t i = 0; i < p.dims(); ++i)
+    z[i] *= s;
+
+  Backend::lower_mult(p.covs_lower(), x);
+  Backend::add_cols(x, p.means());
+
+  return x;
 }
 
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_MV_T_INSTANCES(EXT)                                           \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT, mv_t_distribution)       \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             mv_t_distribution, vector_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_MV_T_INSTANCES(extern)
+#endif
+
 } // namespace baaraan
 
 #endif // BAARAAN_MV_T_DISTRIBUTION_H
@@ -14,77 +14,197 @@
 
 #include <armadillo>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <vector>
+
+#include "../linalg/armadillo_backend.h"
+#include "covariance_factorization.h"
+#include "compiled.h"
+#include "snapshot.h"
 
 namespace baaraan {
 
+namespace detail {
+
+//! Returns a(rows, cols) of a backend matrix
+template <class Backend>
+typename Backend::matrix_type
+select_block(const typename Backend::matrix_type &a,
+             const std::vector<size_t> &rows,
+             const std::vector<size_t> &cols) {
+  typename Backend::matrix_type s;
+  Backend::resize(s, rows.size(), cols.size());
+
+  const size_t lda = Backend::rows(a);
+  const auto *pa = Backend::data(a);
+  auto *ps = Backend::data(s);
+  for (size_t j = 0; j < cols.size(); ++j)
+    for (size_t i = 0; i < rows.size(); ++i)
+      ps[i + j * rows.size()] = pa[rows[i] + cols[j] * lda];
+
+  return s;
+}
+
+//! Returns x(idx) of a backend vector
+template <class Backend>
+typename Backend::vector_type
+select_elems(const typename Backend::vector_type &x,
+             const std::vector<size_t> &idx) {
+  typename Backend::vector_type s;
+  Backend::resize(s, idx.size());
+
+  const auto *px = Backend::data(x);
+  auto *ps = Backend::data(s);
+  for (size_t i = 0; i < idx.size(); ++i)
+    ps[i] = px[idx[i]];
+
+  return s;
+}
+
+} // namespace detail
+
 ///
 /// @brief      Multivariate Normal Random Distribution
 /// 
 /// Implementation of multivariate normal random distribution
 ///
+/// All matrix operations go through the Backend, so draws are returned in
+/// its own containers, e.g., `Eigen::VectorXd` with linalg::eigen_backend.
+///
 /// @tparam     RealType  Indicates the type of return values
+/// @tparam     Backend   The linear algebra backend, see armadillo_backend.h
 /// 
 /// @ingroup    MultivariateDistribution
 ///
-template <class RealType = double> class mvnorm_distribution {
+template <class RealType = double,
+          class Backend = linalg::armadillo_backend<RealType>>
+class mvnorm_distribution {
 public:
   // types
-  typedef arma::Mat<RealType> matrix_type;
-  typedef arma::Col<RealType> vector_type;
+  typedef Backend backend_type;
+  typedef typename Backend::matrix_type matrix_type;
+  typedef typename Backend::vector_type vector_type;
+
+  class conditional_type;
 
   ///
   /// @brief      Multivariate Normal Distribution Parameter Type
   ///
+  /// The covariance matrix and its factorization are shared between copies,
+  /// and the factorization is only computed on its first use.
+  ///
   class param_type {
     size_t dims_;
     vector_type means_;
-    matrix_type sigma_;
 
-    matrix_type covs_lower_;
-    matrix_type inv_covs_lower_;
-    matrix_type inv_covs_;
+    typedef detail::covariance_factorization<RealType, Backend>
+        factorization_type;
 
-    void factorize_covariance() {
-      covs_lower_ = arma::chol(sigma_, "lower");
-      inv_covs_lower_ = arma::inv(arma::trimatl(covs_lower_));
-      inv_covs_ = inv_covs_lower_.t() * inv_covs_lower_;
-    }
+    std::shared_ptr<const factorization_type> f_;
+
+    param_type() : dims_(0) {}
+
+    //! Shares an existing factorization, used by conditional_type
+    param_type(vector_type means, std::shared_ptr<const factorization_type> f)
+        : dims_(Backend::rows(means)), means_(std::move(means)),
+          f_(std::move(f)) {}
+
+    friend class conditional_type;
 
   public:
     typedef mvnorm_distribution distribution_type;
 
     explicit param_type(vector_type means, matrix_type sigma)
-        : dims_(means.n_elem), means_(means), sigma_(sigma) {
+        : dims_(Backend::rows(means)), means_(means) {
 
-      if (!means.is_colvec())
-        throw std::logic_error("Mean should be a column vector.");
-
-      if (sigma.n_rows != dims_)
+      if (Backend::rows(sigma) != dims_)
         throw std::length_error("Covariance matrix has the wrong dimension.");
 
-      if (!sigma.is_symmetric() || !sigma.is_square())
+      if (!Backend::is_symmetric(sigma))
         throw std::logic_error(
             "Covariance matrix is not square or symmetrical.");
 
-      factorize_covariance();
+      f_ = std::make_shared<const factorization_type>(std::move(sigma));
     }
 
     //! Returns the dimension of the distribution
     size_t dims() const { return dims_; }
 
     //! Returns the mean vector of the distribution
-    vector_type means() const { return means_; }
+    const vector_type &means() const { return means_; }
 
     //! Returns the covariance matrix of the distribution
-    matrix_type sigma() const { return sigma_; }
+    const matrix_type &sigma() const { return f_->sigma(); }
+
+    //! Returns the lower Cholesky factor of the covariance matrix
+    const matrix_type &covs_lower() const { return f_->lower(); }
+
+    //! Returns the inverse of the lower Cholesky factor
+    const matrix_type &inv_covs_lower() const { return f_->inv_lower(); }
+
+    //! Returns the inverse of the covariance matrix
+    const matrix_type &inv_covs() const { return f_->inverse(); }
+
+    //! Returns the log-determinant of the covariance matrix
+    RealType log_det() const { return f_->log_det(); }
+
+    ///
+    /// @brief      Conditions the distribution on the coordinates in `given`.
+    ///
+    /// The returned object caches the regression coefficients and the Schur
+    /// complement of the partition, so that every conditional distribution
+    /// it then produces only costs a mean update, see
+    /// conditional_type::given().
+    ///
+    /// @param[in]  given  The indices of the observed coordinates
+    ///
+    conditional_type condition(const std::vector<size_t> &given) const;
+
+    ///
+    /// @brief      Writes the parameters, and the Cholesky factor, to a
+    /// binary snapshot.
+    ///
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_dense<Backend>(os, means_);
+      snapshot::write_dense<Backend>(os, sigma());
+      snapshot::write_dense<Backend>(os, covs_lower());
+    }
 
-    matrix_type covs_lower() const { return covs_lower_; }
-    matrix_type inv_covs() const { return inv_covs_; }
+    ///
+    /// @brief      Reads the parameters written by save(), without
+    /// refactorizing the covariance matrix.
+    ///
+    /// Sets the failbit of the stream if the snapshot is malformed.
+    ///
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      param_type p;
+      matrix_type sigma, lower;
+
+      snapshot::read_dense<Backend>(is, p.means_);
+      snapshot::read_dense<Backend>(is, sigma);
+      snapshot::read_dense<Backend>(is, lower);
+
+      p.dims_ = Backend::rows(p.means_);
+      if (Backend::rows(sigma) != p.dims_ || Backend::cols(sigma) != p.dims_ ||
+          Backend::rows(lower) != p.dims_ || Backend::cols(lower) != p.dims_)
+        is.setstate(std::ios_base::failbit);
+      else
+        snapshot::check_lower(is, Backend::data(lower), p.dims_);
+
+      if (is)
+        p.f_ = std::make_shared<const factorization_type>(std::move(sigma),
+                                                          std::move(lower));
+
+      return p;
+    }
 
     friend bool operator==(const param_type &x, const param_type &y) {
-      return arma::approx_equal(x.means_, y.means_, "absdiff", 0.001) &&
-             arma::approx_equal(x.covs_, y.covs_, "absdiff", 0.001);
+      return Backend::approx_equal(x.means_, y.means_, 0.001) &&
+             (x.f_ == y.f_ ||
+              Backend::approx_equal(x.sigma(), y.sigma(), 0.001));
     }
 
     friend bool operator!=(const param_type &x, const param_type &y) {
@@ -92,11 +212,96 @@ public:
     }
   };
 
+  ///
+  /// @brief      Multivariate Normal Distribution Conditioned on a Fixed Set
+  /// of Coordinates
+  ///
+  /// With the coordinates partitioned into free, f, and given, g, ones,
+  ///
+  ///     x_f | x_g ~ N(mu_f + B (x_g - mu_g), S),
+  ///
+  /// where B = sigma_fg inv(sigma_gg) and S = sigma_ff - B sigma_gf, the
+  /// Schur complement of sigma_gg. Both only depend on the index set, so
+  /// they are computed once, and the Cholesky factor of S is shared by all
+  /// the param_types returned by given(), each only costing an
+  /// O(d_f * d_g) product.
+  ///
+  class conditional_type {
+    std::vector<size_t> free_;
+    std::vector<size_t> given_;
+
+    vector_type free_means_;
+    vector_type given_means_;
+
+    matrix_type reg_;
+    param_type cond_;
+
+  public:
+    conditional_type(const param_type &p, std::vector<size_t> given);
+
+    //! Returns the indices of the free coordinates, in increasing order
+    const std::vector<size_t> &free_indices() const { return free_; }
+
+    //! Returns the indices of the observed coordinates
+    const std::vector<size_t> &given_indices() const { return given_; }
+
+    //! Returns the regression coefficients, B = sigma_fg inv(sigma_gg)
+    const matrix_type &regression() const { return reg_; }
+
+    //! Returns the conditional covariance matrix, i.e., the Schur complement
+    const matrix_type &sigma() const { return cond_.sigma(); }
+
+    //! Returns the lower Cholesky factor of the conditional covariance matrix
+    const matrix_type &covs_lower() const { return cond_.covs_lower(); }
+
+    ///
+    /// @brief      Returns the parameters of the free coordinates given that
+    /// the observed ones are equal to `values`.
+    ///
+    /// @param[in]  values  The observed values, ordered as given_indices()
+    ///
+    param_type given(const vector_type &values) const {
+      if (Backend::rows(values) != given_.size())
+        throw std::length_error("Observed values have the wrong dimension.");
+
+      vector_type means = free_means_;
+      vector_type dev = values;
+      auto *pd = Backend::data(dev);
+      const auto *pm = Backend::data(given_means_);
+      for (size_t i = 0; i < given_.size(); ++i)
+        pd[i] -= pm[i];
+
+      Backend::mult_add(reg_, dev, means);
+
+      return param_type(std::move(means), cond_.f_);
+    }
+  };
+
+  ///
+  /// @brief      Sampler State of the Distribution
+  ///
+  /// Holds everything a draw mutates. The const overloads of operator() take
+  /// it from the caller, so that a single distribution, and the
+  /// factorization of its covariance matrix, can be shared read-only by a
+  /// pool of threads, each owning a context.
+  ///
+  /// @code
+  /// // in every worker
+  /// mvnorm_distribution<>::context_type ctx;
+  /// std::mt19937 gen(seed);
+  /// arma::mat sample = shared_mvnorm(gen, ctx, n);
+  /// @endcode
+  ///
+  struct context_type {
+    std::normal_distribution<> norm; // N~(0, 1)
+
+    void reset() { norm.reset(); }
+  };
+
 private:
-  std::normal_distribution<> norm_; // N~(0, 1)
+  context_type ctx_;
 
   param_type p_;
-  vector_type v_;
 
 public:
   // constructor and reset functions
@@ -120,22 +325,45 @@ public:
   explicit mvnorm_distribution(vector_type means, matrix_type sigma)
       : p_(param_type(means, sigma)) {}
 
-  void reset() { norm_.reset(); };
+  void reset() { ctx_.reset(); };
 
   // generating functions
   template <class URNG> vector_type operator()(URNG &g) {
-    return (*this)(g, p_);
+    return (*this)(g, ctx_, p_);
   }
 
-  template <class URNG> vector_type operator()(URNG &g, const param_type &p);
+  template <class URNG> vector_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
 
   // batch generation
   template <class URNG> matrix_type operator()(URNG &g, size_t n) {
-    return (*this)(g, p_, n);
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
   }
 
   template <class URNG>
-  matrix_type operator()(URNG &g, const param_type &p, size_t n);
+  matrix_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                         size_t n) const;
 
   // property functions
 
@@ -149,13 +377,13 @@ public:
 
 public:
   vector_type min() const {
-    return vector_type(p_.dims()).fill(
-        -std::numeric_limits<RealType>::infinity());
+    return Backend::constant(p_.dims(),
+                             -std::numeric_limits<RealType>::infinity());
   }
 
   vector_type max() const {
-    return vector_type(p_.dims()).fill(
-        +std::numeric_limits<RealType>::infinity());
+    return Backend::constant(p_.dims(),
+                             +std::numeric_limits<RealType>::infinity());
   }
 
   friend bool operator==(const mvnorm_distribution &x,
@@ -168,44 +396,157 @@ public:
     return !(x == y);
   }
 
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
   template <class charT, class traits>
   friend std::basic_ostream<charT, traits> &
   operator<<(std::basic_ostream<charT, traits> &os,
-             const mvnorm_distribution &means);
+             const mvnorm_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::mvnorm, sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.norm);
+    return os;
+  }
 
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
   template <class charT, class traits>
   friend std::basic_istream<charT, traits> &
-  operator>>(std::basic_istream<charT, traits> &is, mvnorm_distribution &means);
+  operator>>(std::basic_istream<charT, traits> &is, mvnorm_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::mvnorm, sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::normal_distribution<> norm;
+    snapshot::read_state(is, norm);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.norm = norm;
+    }
+    return is;
+  }
 };
 
-template <class RealType>
+template <class RealType, class Backend>
+typename mvnorm_distribution<RealType, Backend>::conditional_type
+mvnorm_distribution<RealType, Backend>::param_type::condition(
+    const std::vector<size_t> &given) const {
+  return conditional_type(*this, given);
+}
+
+template <class RealType, class Backend>
+mvnorm_distribution<RealType, Backend>::conditional_type::conditional_type(
+    const param_type &p, std::vector<size_t> given)
+    : given_(std::move(given)) {
+
+  const size_t d = p.dims();
+  if (given_.empty() || given_.size() >= d)
+    throw std::logic_error(
+        "At least one coordinate should be given, and one left free.");
+
+  std::vector<bool> is_given(d, false);
+  for (const size_t i : given_) {
+    if (i >= d)
+      throw std::out_of_range("Given index is out of range.");
+    if (is_given[i])
+      throw std::logic_error("Given indices should be unique.");
+    is_given[i] = true;
+  }
+
+  for (size_t i = 0; i < d; ++i)
+    if (!is_given[i])
+      free_.push_back(i);
+
+  free_means_ = detail::select_elems<Backend>(p.means(), free_);
+  given_means_ = detail::select_elems<Backend>(p.means(), given_);
+
+  // With sigma_gg = L L' and W = inv(L) sigma_gf, B = W' inv(L) and
+  // S = sigma_ff - W' W
+  const matrix_type inv_l = Backend::inverse_lower(Backend::cholesky(
+      detail::select_block<Backend>(p.sigma(), given_, given_)));
+
+  matrix_type w = detail::select_block<Backend>(p.sigma(), given_, free_);
+  Backend::lower_mult(inv_l, w);
+
+  reg_ = Backend::crossprod(w, inv_l);
+
+  matrix_type schur = detail::select_block<Backend>(p.sigma(), free_, free_);
+  const matrix_type ww = Backend::crossprod(w);
+
+  const size_t n = free_.size();
+  auto *ps = Backend::data(schur);
+  const auto *pw = Backend::data(ww);
+  for (size_t j = 0; j < n; ++j)
+    for (size_t i = 0; i <= j; ++i) {
+      // averaged, so that rounding does not break the symmetry
+      const RealType v = ps[i + j * n] - (pw[i + j * n] + pw[j + i * n]) / 2;
+      ps[i + j * n] = v;
+      ps[j + i * n] = v;
+    }
+
+  cond_ = param_type(free_means_, std::move(schur));
+}
+
+template <class RealType, class Backend>
 template <class URNG>
-typename mvnorm_distribution<RealType>::vector_type
-mvnorm_distribution<RealType>::operator()(
-    URNG &g, const mvnorm_distribution<RealType>::param_type &p) {
-
-  v_.resize(p.dims(), 1);
-  v_.imbue([&]() { return norm_(g); });
-  // if (p.is_covs_diagmat()) {
-  //     return arma::sqrt(p.covs_diag()) % v_ + p.means();
-  // } else {
-  return p.covs_lower() * v_ + p.means();
-  // }
+typename mvnorm_distribution<RealType, Backend>::vector_type
+mvnorm_distribution<RealType, Backend>::operator()(URNG &g, context_type &ctx,
+                                                   const param_type &p) const {
+
+  vector_type x;
+  Backend::resize(x, p.dims());
+
+  RealType *z = Backend::data(x);
+  for (size_t i = 0; i < p.dims(); ++i)
+    z[i] = ctx.norm(g);
+
+  Backend::lower_mult(p.covs_lower(), x);
+  Backend::add_cols(x, p.means());
+
+  return x;
 }
 
-template <class RealType>
+///
+/// The normal values are drawn column by column, in the same order as n
+/// single draws, and all columns are then transformed by a single
+/// triangular matrix product.
+///
+template <class RealType, class Backend>
 template <class URNG>
-typename mvnorm_distribution<RealType>::matrix_type
-mvnorm_distribution<RealType>::operator()(
-    URNG &g, const mvnorm_distribution<RealType>::param_type &p, size_t n) {
+typename mvnorm_distribution<RealType, Backend>::matrix_type
+mvnorm_distribution<RealType, Backend>::operator()(URNG &g, context_type &ctx,
+                                                   const param_type &p,
+                                                   size_t n) const {
 
-  arma::Mat<RealType> res(p.dims(), n);
+  matrix_type res;
+  Backend::resize(res, p.dims(), n);
 
-  res.each_col([&](vector_type &col) { col = (*this)(g, p); });
+  RealType *z = Backend::data(res);
+  for (size_t i = 0; i < p.dims() * n; ++i)
+    z[i] = ctx.norm(g);
+
+  Backend::lower_mult(p.covs_lower(), res);
+  Backend::add_cols(res, p.means());
 
   return res;
 }
 
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_MVNORM_INSTANCES(EXT)                                         \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT, mvnorm_distribution)     \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             mvnorm_distribution, vector_type)                \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_BATCH_INSTANCE, EXT,                     \
+                             mvnorm_distribution, matrix_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_MVNORM_INSTANCES(extern)
+#endif
+
 } // namespace baaraan
 
 #endif // BAARAAN_MVNORM_DISTRIBUTION_H
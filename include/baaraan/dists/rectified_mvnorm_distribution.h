@@ -0,0 +1,306 @@
+///
+/// @file
+/// This file contains the implementation of the rectified multivariate normal
+/// random distribution, i.e., max(0, X) where X ~ N(means, sigma).
+///
+
+#ifndef BAARAAN_RECTIFIED_MVNORM_DISTRIBUTION_H
+#define BAARAAN_RECTIFIED_MVNORM_DISTRIBUTION_H
+
+#include <armadillo>
+#include <iostream>
+#include <random>
+
+#include "mvnorm_distribution.h"
+#include "compiled.h"
+#include "snapshot.h"
+
+namespace baaraan {
+
+///
+/// @brief      Rectified Multivariate Normal Random Distribution
+///
+/// Every coordinate of a correlated normal draw is independently clamped at
+/// zero. The distribution reuses the Cholesky factorization of
+/// mvnorm_distribution::param_type, on the same Backend.
+///
+/// @tparam     RealType  Indicates the type of return values
+/// @tparam     Backend   The linear algebra backend, see armadillo_backend.h
+///
+/// @ingroup    MultivariateDistribution
+/// @ingroup    RectifiedDistributions
+///
+template <class RealType = double,
+          class Backend = linalg::armadillo_backend<RealType>>
+class rectified_mvnorm_distribution {
+public:
+  // types
+  typedef Backend backend_type;
+  typedef typename Backend::matrix_type matrix_type;
+  typedef typename Backend::vector_type vector_type;
+
+  typedef mvnorm_distribution<RealType, Backend> normal_type;
+
+  ///
+  /// @brief      Rectified Multivariate Normal Distribution Parameter Type
+  ///
+  class param_type {
+    typename normal_type::param_type norm_p_;
+
+  public:
+    typedef rectified_mvnorm_distribution distribution_type;
+
+    explicit param_type(vector_type means, matrix_type sigma)
+        : norm_p_(means, sigma) {}
+
+    explicit param_type(const typename normal_type::param_type &p)
+        : norm_p_(p) {}
+
+    //! Returns the dimension of the distribution
+    size_t dims() const { return norm_p_.dims(); }
+
+    //! Returns the mean vector of the underlying normal distribution
+    const vector_type &means() const { return norm_p_.means(); }
+
+    //! Returns the covariance matrix of the underlying normal distribution
+    const matrix_type &sigma() const { return norm_p_.sigma(); }
+
+    //! Returns the lower Cholesky factor of the covariance matrix
+    const matrix_type &covs_lower() const { return norm_p_.covs_lower(); }
+
+    //! Returns the parameters of the underlying normal distribution
+    const typename normal_type::param_type &normal_param() const {
+      return norm_p_;
+    }
+
+    //! Writes the parameters, and the Cholesky factor, to a binary snapshot
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      norm_p_.save(os);
+    }
+
+    //! Reads the parameters written by save()
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      return param_type(normal_type::param_type::load(is));
+    }
+
+    friend bool operator==(const param_type &x, const param_type &y) {
+      return x.norm_p_ == y.norm_p_;
+    }
+
+    friend bool operator!=(const param_type &x, const param_type &y) {
+      return !(x == y);
+    }
+  };
+
+  //! Normals of the latent mvnorm draw, before it is clipped at zero
+  struct context_type {
+    std::normal_distribution<RealType> norm; // N~(0, 1)
+
+    void reset() { norm.reset(); }
+  };
+
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+  //! Adds the means to every column of x and clamps the result at zero in a
+  //! single pass
+  template <class T>
+  static void shift_and_rectify(T &x, const vector_type &means) {
+    const size_t d = Backend::rows(x);
+    const RealType *mu = Backend::data(means);
+
+    RealType *col = Backend::data(x);
+    for (size_t j = 0; j < Backend::cols(x); ++j, col += d)
+      for (size_t i = 0; i < d; ++i) {
+        RealType y = col[i] + mu[i];
+        col[i] = y < 0 ? RealType(0) : y;
+      }
+  }
+
+public:
+  // constructor and reset functions
+
+  ///
+  /// @brief      Constructs an instance of the rectified multivariate normal
+  /// distribution by accepting an instance of
+  /// rectified_mvnorm_distribution::param_type.
+  ///
+  /// @param[in]  p
+  ///
+  explicit rectified_mvnorm_distribution(const param_type &p) : p_(p) {}
+
+  ///
+  /// @brief      Constructs an instance of the rectified multivariate normal
+  /// distribution by accepting the mean vector and the covariance matrix of
+  /// the underlying normal distribution.
+  ///
+  /// @param[in]  means  The mean vector.
+  /// @param[in]  sigma  The covariance matrix.
+  ///
+  explicit rectified_mvnorm_distribution(vector_type means, matrix_type sigma)
+      : p_(param_type(means, sigma)) {}
+
+  void reset() { ctx_.reset(); };
+
+  // generating functions
+  template <class URNG> vector_type operator()(URNG &g) {
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> vector_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // batch generation
+  template <class URNG> matrix_type operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  matrix_type operator()(URNG &g, context_type &ctx, const param_type &p,
+                         size_t n) const;
+
+  // property functions
+
+  vector_type means() const { return p_.means(); }
+
+  matrix_type sigma() const { return p_.sigma(); }
+
+  param_type param() const { return p_; }
+
+  void param(const param_type &p) { p_ = p; }
+
+public:
+  vector_type min() const { return Backend::constant(p_.dims(), 0); }
+
+  vector_type max() const {
+    return Backend::constant(p_.dims(),
+                             +std::numeric_limits<RealType>::infinity());
+  }
+
+  friend bool operator==(const rectified_mvnorm_distribution &x,
+                         const rectified_mvnorm_distribution &y) {
+    return x.p_ == y.p_;
+  }
+
+  friend bool operator!=(const rectified_mvnorm_distribution &x,
+                         const rectified_mvnorm_distribution &y) {
+    return !(x == y);
+  }
+
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+  ///
+  template <class charT, class traits>
+  friend std::basic_ostream<charT, traits> &
+  operator<<(std::basic_ostream<charT, traits> &os,
+             const rectified_mvnorm_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::rectified_mvnorm,
+                           sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.norm);
+    return os;
+  }
+
+  ///
+  /// @brief      Restores a distribution from its binary snapshot. The
+  /// distribution is left unchanged if the snapshot cannot be read.
+  ///
+  template <class charT, class traits>
+  friend std::basic_istream<charT, traits> &
+  operator>>(std::basic_istream<charT, traits> &is,
+             rectified_mvnorm_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::rectified_mvnorm,
+                               sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::normal_distribution<RealType> norm;
+    snapshot::read_state(is, norm);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.norm = norm;
+    }
+    return is;
+  }
+};
+
+template <class RealType, class Backend>
+template <class URNG>
+typename rectified_mvnorm_distribution<RealType, Backend>::vector_type
+rectified_mvnorm_distribution<RealType, Backend>::operator()(
+    URNG &g, context_type &ctx, const param_type &p) const {
+
+  vector_type x;
+  Backend::resize(x, p.dims());
+
+  RealType *z = Backend::data(x);
+  for (size_t i = 0; i < p.dims(); ++i)
+    z[i] = ctx.norm(g);
+
+  Backend::lower_mult(p.covs_lower(), x);
+  shift_and_rectify(x, p.means());
+
+  return x;
+}
+
+template <class RealType, class Backend>
+template <class URNG>
+typename rectified_mvnorm_distribution<RealType, Backend>::matrix_type
+rectified_mvnorm_distribution<RealType, Backend>::operator()(
+    URNG &g, context_type &ctx, const param_type &p, size_t n) const {
+
+  matrix_type res;
+  Backend::resize(res, p.dims(), n);
+
+  RealType *z = Backend::data(res);
+  for (size_t i = 0; i < p.dims() * n; ++i)
+    z[i] = ctx.norm(g);
+
+  Backend::lower_mult(p.covs_lower(), res);
+  shift_and_rectify(res, p.means());
+
+  return res;
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_RECTIFIED_MVNORM_INSTANCES(EXT)                               \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT,                          \
+                        rectified_mvnorm_distribution)                        \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             rectified_mvnorm_distribution, vector_type)      \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_BATCH_INSTANCE, EXT,                     \
+                             rectified_mvnorm_distribution, matrix_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_RECTIFIED_MVNORM_INSTANCES(extern)
+#endif
+
+} // namespace baaraan
+
+#endif // BAARAAN_RECTIFIED_MVNORM_DISTRIBUTION_H
@@ -12,6 +12,10 @@
 
 #include <iostream>
 #include <random>
+#include <vector>
+
+#include "compiled.h"
+#include "snapshot.h"
 
 #include "boost/math/distributions/normal.hpp"
 using boost::math::normal;
@@ -45,6 +49,22 @@ public:
 
     result_type stddev() const { return stddev_; }
 
+    //! Writes the parameters to a binary snapshot
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_pod(os, mean_);
+      snapshot::write_pod(os, stddev_);
+    }
+
+    //! Reads the parameters written by save()
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      result_type mean{0}, stddev{1};
+      snapshot::read_pod(is, mean);
+      snapshot::read_pod(is, stddev);
+      return param_type(mean, stddev);
+    }
+
     friend bool operator==(const param_type &x, const param_type &y) {
       return x.mean_ == y.mean_ && x.stddev_ == y.stddev_;
     }
@@ -54,9 +74,16 @@ public:
     }
   };
 
+  //! Standard normal of the latent draw, before it is clipped at zero
+  struct context_type {
+    std::normal_distribution<RealType> norm; // N~(0, 1)
+
+    void reset() { norm.reset(); }
+  };
+
 private:
   param_type p_;
-  std::normal_distribution<> norm_;
+  context_type ctx_;
 
 public:
   ///
@@ -69,7 +96,7 @@ public:
   ///
   explicit rectified_normal_distribution(result_type mean = 0,
                                          result_type stddev = 1)
-      : p_(param_type(mean, stddev)), norm_(std::normal_distribution<>::param_type{mean, stddev}) {}
+      : p_(param_type(mean, stddev)) {}
 
   ///
   /// @brief      Constructs an instance Rectified Normal Distribution by 
@@ -79,14 +106,77 @@ public:
   ///
   explicit rectified_normal_distribution(const param_type &p) : p_(p) {}
 
-  void reset() { norm_.reset(); }
+  void reset() { ctx_.reset(); }
 
   // generating functions
   template <class URNG> result_type operator()(URNG &g) {
-    return (*this)(g, p_);
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> result_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
   }
 
-  template <class URNG> result_type operator()(URNG &g, const param_type &p);
+  // batch generation
+  template <class URNG> std::vector<result_type> operator()(URNG &g, size_t n) {
+    return (*this)(g, ctx_, p_, n);
+  }
+
+  template <class URNG>
+  std::vector<result_type> operator()(URNG &g, const param_type &p, size_t n) {
+    return (*this)(g, ctx_, p, n);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  result_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  result_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
+
+  template <class URNG>
+  std::vector<result_type> operator()(URNG &g, context_type &ctx,
+                                      size_t n) const {
+    return (*this)(g, ctx, p_, n);
+  }
+
+  template <class URNG>
+  std::vector<result_type> operator()(URNG &g, context_type &ctx,
+                                      const param_type &p, size_t n) const {
+    std::vector<result_type> res(n);
+    generate(res.begin(), res.end(), g, ctx, p);
+    return res;
+  }
+
+  ///
+  /// @brief      Fills the range [first, last) with rectified normal values.
+  ///
+  /// The range is first filled with normal draws, and then rectified in a
+  /// separate branch-free pass that the compiler can vectorize.
+  ///
+  template <class ForwardIt, class URNG>
+  void generate(ForwardIt first, ForwardIt last, URNG &g) {
+    generate(first, last, g, ctx_, p_);
+  }
+
+  template <class ForwardIt, class URNG>
+  void generate(ForwardIt first, ForwardIt last, URNG &g,
+                const param_type &p) {
+    generate(first, last, g, ctx_, p);
+  }
+
+  template <class ForwardIt, class URNG>
+  void generate(ForwardIt first, ForwardIt last, URNG &g,
+                context_type &ctx) const {
+    generate(first, last, g, ctx, p_);
+  }
+
+  template <class ForwardIt, class URNG>
+  void generate(ForwardIt first, ForwardIt last, URNG &g, context_type &ctx,
+                const param_type &p) const;
 
   // property functions
   result_type mean() const { return p_.mean(); }
@@ -125,11 +215,76 @@ public:
 template <class RealType>
 template <class URNG>
 RealType
-rectified_normal_distribution<RealType>::operator()(URNG &g,
-                                                    const param_type &parm) {
-  return max(0, norm_(g, parm));
+rectified_normal_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx, const param_type &parm) const {
+  result_type x = parm.mean() + parm.stddev() * ctx.norm(g);
+  return x < 0 ? result_type(0) : x;
+}
+
+template <class RealType>
+template <class ForwardIt, class URNG>
+void rectified_normal_distribution<RealType>::generate(
+    ForwardIt first, ForwardIt last, URNG &g, context_type &ctx,
+    const param_type &parm) const {
+  const result_type mean = parm.mean();
+  const result_type stddev = parm.stddev();
+
+  for (ForwardIt it = first; it != last; ++it)
+    *it = mean + stddev * ctx.norm(g);
+
+  for (ForwardIt it = first; it != last; ++it)
+    *it = *it < 0 ? result_type(0) : *it;
+}
+
+///
+/// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+///
+template <class _CharT, class _Traits, class _RT>
+std::basic_ostream<_CharT, _Traits> &
+operator<<(std::basic_ostream<_CharT, _Traits> &os,
+           const rectified_normal_distribution<_RT> &x) {
+  snapshot::write_header(os, snapshot::kind::rectified_normal, sizeof(_RT));
+  x.p_.save(os);
+  snapshot::write_state(os, x.ctx_.norm);
+  return os;
+}
+
+///
+/// @brief      Restores a distribution from its binary snapshot. The
+/// distribution is left unchanged if the snapshot cannot be read.
+///
+template <class _CharT, class _Traits, class _RT>
+std::basic_istream<_CharT, _Traits> &
+operator>>(std::basic_istream<_CharT, _Traits> &is,
+           rectified_normal_distribution<_RT> &x) {
+  typedef typename rectified_normal_distribution<_RT>::param_type param_type;
+
+  if (!snapshot::read_header(is, snapshot::kind::rectified_normal,
+                             sizeof(_RT)))
+    return is;
+
+  param_type p = param_type::load(is);
+  std::normal_distribution<_RT> norm;
+  snapshot::read_state(is, norm);
+
+  if (is) {
+    x.p_ = p;
+    x.ctx_.norm = norm;
+  }
+  return is;
 }
 
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_RECTIFIED_NORMAL_INSTANCES(EXT)                               \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT,                          \
+                        rectified_normal_distribution)                        \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             rectified_normal_distribution, result_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_RECTIFIED_NORMAL_INSTANCES(extern)
+#endif
+
 } // namespace baaraan
 
 #endif // BAARAAN_RECTIFIED_NORMAL_DISTRIBUTION_H
@@ -0,0 +1,385 @@
+///
+/// @file
+/// This file contains the building blocks of baaraan's binary snapshot
+/// format, used by the distributions' operator<< and operator>>.
+///
+/// A snapshot starts with a fixed header, i.e., a magic number, the format
+/// version, the kind of the distribution and the size of its RealType,
+/// followed by the distribution's parameters, their precomputed
+/// factorizations, and its sampler state. Matrices are stored as their
+/// dimensions followed by their raw, column-major memory, so that they are
+/// restored with a single read, and without any refactorization.
+///
+/// Snapshots are meant to be written to and read from streams opened in
+/// binary mode, on machines with the same endianness.
+///
+/// @code
+/// std::ofstream out("mvnorm.bin", std::ios::binary);
+/// out << mvnorm;
+/// baaraan::snapshot::write_state(out, gen);
+/// @endcode
+///
+
+#ifndef BAARAAN_SNAPSHOT_H
+#define BAARAAN_SNAPSHOT_H
+
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace baaraan {
+
+namespace snapshot {
+
+//! "BRNS" in little-endian order
+constexpr std::uint32_t magic = 0x534e5242;
+
+//! Current version of the snapshot format
+constexpr std::uint32_t version = 1;
+
+//! Identifies the distribution stored in a snapshot
+enum class kind : std::uint32_t {
+  mvnorm = 1,
+  mv_t = 2,
+  truncated_mvnorm = 3,
+  truncated_normal = 4,
+  rectified_normal = 5,
+  rectified_mvnorm = 6,
+  mixture_mvnorm = 7,
+  wishart = 8,
+  inverse_wishart = 9,
+  matrix_normal = 10,
+  circulant_mvnorm = 11,
+  dirichlet = 12,
+  multinomial = 13,
+  gmrf = 14
+};
+
+template <class charT, class traits, class T>
+void write_pod(std::basic_ostream<charT, traits> &os, const T &v) {
+  static_assert(sizeof(charT) == 1, "Snapshots need a byte stream.");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Only trivially copyable values can be written directly.");
+  os.write(reinterpret_cast<const charT *>(&v), sizeof(T));
+}
+
+template <class charT, class traits, class T>
+void read_pod(std::basic_istream<charT, traits> &is, T &v) {
+  static_assert(sizeof(charT) == 1, "Snapshots need a byte stream.");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Only trivially copyable values can be read directly.");
+  is.read(reinterpret_cast<charT *>(&v), sizeof(T));
+}
+
+template <class charT, class traits>
+void write_header(std::basic_ostream<charT, traits> &os, kind k,
+                  std::uint32_t real_size) {
+  write_pod(os, magic);
+  write_pod(os, version);
+  write_pod(os, static_cast<std::uint32_t>(k));
+  write_pod(os, real_size);
+}
+
+///
+/// @brief      Reads and validates a snapshot header.
+///
+/// Sets the failbit of the stream if the header does not belong to a
+/// snapshot of the expected kind and RealType, or if it has been written by
+/// a newer version of the format.
+///
+template <class charT, class traits>
+bool read_header(std::basic_istream<charT, traits> &is, kind k,
+                 std::uint32_t real_size) {
+  std::uint32_t m{0}, v{0}, sk{0}, rs{0};
+  read_pod(is, m);
+  read_pod(is, v);
+  read_pod(is, sk);
+  read_pod(is, rs);
+
+  if (!is || m != magic || v == 0 || v > version ||
+      sk != static_cast<std::uint32_t>(k) || rs != real_size) {
+    is.setstate(std::ios_base::failbit);
+    return false;
+  }
+
+  return true;
+}
+
+///
+/// @brief      Checks that n elements of the given size are left in the
+/// stream, before a buffer is allocated for them.
+///
+/// Sets the failbit of the stream if their total size overflows, or, for
+/// seekable streams, if it exceeds the remaining length of the stream, so
+/// that truncated or corrupt snapshots fail to load instead of allocating
+/// the sizes they claim.
+///
+template <class charT, class traits>
+bool check_size(std::basic_istream<charT, traits> &is, std::uint64_t n,
+                std::uint64_t size) {
+  if (!is)
+    return false;
+
+  const std::uint64_t max_bytes =
+      std::min<std::uint64_t>(std::numeric_limits<std::streamsize>::max(),
+                              std::numeric_limits<std::size_t>::max());
+  if (size != 0 && n > max_bytes / size) {
+    is.setstate(std::ios_base::failbit);
+    return false;
+  }
+
+  const auto pos = is.tellg();
+  if (pos == decltype(pos)(-1))
+    return true;
+
+  is.seekg(0, std::ios_base::end);
+  const auto end = is.tellg();
+  is.seekg(pos);
+
+  if (!is || end == decltype(end)(-1) ||
+      static_cast<std::uint64_t>(end - pos) < n * size) {
+    is.setstate(std::ios_base::failbit);
+    return false;
+  }
+
+  return true;
+}
+
+//! check_size() for a rows x cols matrix
+template <class charT, class traits>
+bool check_shape(std::basic_istream<charT, traits> &is, std::uint64_t rows,
+                 std::uint64_t cols, std::uint64_t size) {
+  if (cols != 0 && rows > std::numeric_limits<std::uint64_t>::max() / cols) {
+    is.setstate(std::ios_base::failbit);
+    return false;
+  }
+
+  return check_size(is, rows * cols, size);
+}
+
+///
+/// @brief      Checks a lower Cholesky factor restored from a snapshot.
+///
+/// Sets the failbit of the stream unless the n x n column-major matrix l is
+/// finite and lower triangular, with a positive diagonal.
+///
+template <class charT, class traits, class eT>
+bool check_lower(std::basic_istream<charT, traits> &is, const eT *l,
+                 std::uint64_t n) {
+  for (std::uint64_t j = 0; j < n; ++j) {
+    bool valid = l[j * n + j] > 0;
+    for (std::uint64_t i = 0; valid && i < n; ++i)
+      valid = std::isfinite(l[j * n + i]) && (i >= j || l[j * n + i] == 0);
+
+    if (!valid) {
+      is.setstate(std::ios_base::failbit);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template <class charT, class traits, class eT>
+void write_matrix(std::basic_ostream<charT, traits> &os,
+                  const arma::Mat<eT> &x) {
+  write_pod(os, static_cast<std::uint64_t>(x.n_rows));
+  write_pod(os, static_cast<std::uint64_t>(x.n_cols));
+  os.write(reinterpret_cast<const charT *>(x.memptr()),
+           x.n_elem * sizeof(eT));
+}
+
+template <class charT, class traits, class eT>
+void read_matrix(std::basic_istream<charT, traits> &is, arma::Mat<eT> &x) {
+  std::uint64_t rows{0}, cols{0};
+  read_pod(is, rows);
+  read_pod(is, cols);
+  if (!check_shape(is, rows, cols, sizeof(eT)))
+    return;
+
+  x.set_size(rows, cols);
+  is.read(reinterpret_cast<charT *>(x.memptr()), x.n_elem * sizeof(eT));
+}
+
+template <class charT, class traits, class eT>
+void write_vector(std::basic_ostream<charT, traits> &os,
+                  const arma::Col<eT> &x) {
+  write_matrix(os, static_cast<const arma::Mat<eT> &>(x));
+}
+
+template <class charT, class traits, class eT>
+void read_vector(std::basic_istream<charT, traits> &is, arma::Col<eT> &x) {
+  std::uint64_t rows{0}, cols{0};
+  read_pod(is, rows);
+  read_pod(is, cols);
+  if (!is || cols != 1) {
+    is.setstate(std::ios_base::failbit);
+    return;
+  }
+
+  if (!check_size(is, rows, sizeof(eT)))
+    return;
+
+  x.set_size(rows);
+  is.read(reinterpret_cast<charT *>(x.memptr()), x.n_elem * sizeof(eT));
+}
+
+template <class charT, class traits, class T>
+void write_vector(std::basic_ostream<charT, traits> &os,
+                  const std::vector<T> &x) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Only trivially copyable values can be written directly.");
+  write_pod(os, static_cast<std::uint64_t>(x.size()));
+  os.write(reinterpret_cast<const charT *>(x.data()), x.size() * sizeof(T));
+}
+
+template <class charT, class traits, class T>
+void read_vector(std::basic_istream<charT, traits> &is, std::vector<T> &x) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Only trivially copyable values can be read directly.");
+  std::uint64_t n{0};
+  read_pod(is, n);
+  if (!check_size(is, n, sizeof(T)))
+    return;
+
+  x.resize(n);
+  is.read(reinterpret_cast<charT *>(x.data()), n * sizeof(T));
+}
+
+///
+/// @brief      Writes a sparse matrix as its dimensions, followed by the
+/// (row, column) locations and the values of its non-zero elements.
+///
+template <class charT, class traits, class eT>
+void write_sparse(std::basic_ostream<charT, traits> &os,
+                  const arma::SpMat<eT> &x) {
+  write_pod(os, static_cast<std::uint64_t>(x.n_rows));
+  write_pod(os, static_cast<std::uint64_t>(x.n_cols));
+  write_pod(os, static_cast<std::uint64_t>(x.n_nonzero));
+
+  for (auto it = x.begin(); it != x.end(); ++it) {
+    write_pod(os, static_cast<std::uint64_t>(it.row()));
+    write_pod(os, static_cast<std::uint64_t>(it.col()));
+    write_pod(os, static_cast<eT>(*it));
+  }
+}
+
+template <class charT, class traits, class eT>
+void read_sparse(std::basic_istream<charT, traits> &is, arma::SpMat<eT> &x) {
+  std::uint64_t rows{0}, cols{0}, nnz{0};
+  read_pod(is, rows);
+  read_pod(is, cols);
+  read_pod(is, nnz);
+
+  // every non-zero is stored as a (row, column, value) triplet
+  if (!check_shape(is, rows, cols, 0) ||
+      !check_size(is, nnz, 2 * sizeof(std::uint64_t) + sizeof(eT)))
+    return;
+
+  arma::umat locations(2, nnz);
+  arma::Col<eT> values(nnz);
+  for (std::uint64_t i = 0; i < nnz; ++i) {
+    std::uint64_t r{0}, c{0};
+    eT v{0};
+    read_pod(is, r);
+    read_pod(is, c);
+    read_pod(is, v);
+    if (!is || r >= rows || c >= cols) {
+      is.setstate(std::ios_base::failbit);
+      return;
+    }
+    locations(0, i) = r;
+    locations(1, i) = c;
+    values[i] = v;
+  }
+
+  x = arma::SpMat<eT>(locations, values, rows, cols);
+}
+
+///
+/// @brief      Writes a matrix or a vector of a linear algebra backend, in the
+/// same layout as write_matrix().
+///
+template <class Backend, class charT, class traits, class T>
+void write_dense(std::basic_ostream<charT, traits> &os, const T &x) {
+  typedef typename Backend::value_type eT;
+
+  const std::uint64_t rows = Backend::rows(x), cols = Backend::cols(x);
+  write_pod(os, rows);
+  write_pod(os, cols);
+  os.write(reinterpret_cast<const charT *>(Backend::data(x)),
+           rows * cols * sizeof(eT));
+}
+
+///
+/// @brief      Reads the matrix or the vector written by write_dense(), or
+/// write_matrix(), and sets the failbit if its shape does not fit in T.
+///
+template <class Backend, class charT, class traits, class T>
+void read_dense(std::basic_istream<charT, traits> &is, T &x) {
+  typedef typename Backend::value_type eT;
+
+  std::uint64_t rows{0}, cols{0};
+  read_pod(is, rows);
+  read_pod(is, cols);
+  if (!check_shape(is, rows, cols, sizeof(eT)))
+    return;
+
+  Backend::resize(x, rows, cols);
+  if (Backend::rows(x) != rows || Backend::cols(x) != cols) {
+    is.setstate(std::ios_base::failbit);
+    return;
+  }
+
+  is.read(reinterpret_cast<charT *>(Backend::data(x)),
+          rows * cols * sizeof(eT));
+}
+
+///
+/// @brief      Writes the state of any object supporting the standard
+/// textual operator<<, e.g., the STL random engines and distributions, as a
+/// length-prefixed string.
+///
+template <class charT, class traits, class T>
+void write_state(std::basic_ostream<charT, traits> &os, const T &x) {
+  std::ostringstream ss;
+  ss << x;
+  const std::string s = ss.str();
+
+  write_pod(os, static_cast<std::uint64_t>(s.size()));
+  os.write(reinterpret_cast<const charT *>(s.data()), s.size());
+}
+
+///
+/// @brief      Reads the state written by write_state().
+///
+template <class charT, class traits, class T>
+void read_state(std::basic_istream<charT, traits> &is, T &x) {
+  std::uint64_t n{0};
+  read_pod(is, n);
+  if (!check_size(is, n, 1))
+    return;
+
+  std::string s(n, '\0');
+  is.read(reinterpret_cast<charT *>(&s[0]), n);
+  if (!is)
+    return;
+
+  std::istringstream ss(s);
+  ss >> x;
+  if (!ss)
+    is.setstate(std::ios_base::failbit);
+}
+
+} // namespace snapshot
+
+} // namespace baaraan
+
+#endif // BAARAAN_SNAPSHOT_H
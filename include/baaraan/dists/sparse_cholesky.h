@@ -0,0 +1,505 @@
+///
+/// @file
+/// This file contains the sparse Cholesky factorization of a precision
+/// matrix, used by gmrf_distribution.
+///
+
+#ifndef BAARAAN_SPARSE_CHOLESKY_H
+#define BAARAAN_SPARSE_CHOLESKY_H
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "snapshot.h"
+
+namespace baaraan {
+
+namespace detail {
+
+///
+/// @brief      Sparse Cholesky factorization, P Q P' = L L'
+///
+/// The rows and columns of Q are first reordered by nested dissection of
+/// its graph: every connected subgraph is split by the median level of a
+/// breadth-first search from a pseudo-peripheral node, and the separating
+/// nodes are ordered after both halves, recursively, down to subgraphs of
+/// leaf_size nodes. For a k x k grid, L then has O(n log n) non-zeros, with
+/// n = k^2, rather than the O(n^1.5) of profile reducing orderings. L is
+/// computed by the up-looking algorithm of CSparse, row by row, from the
+/// elimination tree of the permuted matrix, and is stored in compressed
+/// sparse columns, with its diagonal first in every column. Memory and
+/// solve costs are proportional to the non-zeros of L.
+///
+/// All vectors passed to the solvers are in the permuted order, see perm().
+///
+/// @tparam     RealType  Indicates the type of the matrix elements
+///
+template <class RealType> class sparse_cholesky {
+  size_t n_;
+
+  // perm_[k] is the row of Q that became the k-th row of L
+  std::vector<size_t> perm_;
+
+  std::vector<size_t> lp_;
+  std::vector<size_t> li_;
+  std::vector<RealType> lx_;
+
+  static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+  sparse_cholesky() : n_(0) {}
+
+  //! Subgraphs up to this size are not dissected any further
+  static constexpr size_t leaf_size = 8;
+
+  //! Returns a nested dissection ordering of a symmetric pattern
+  static std::vector<size_t> nested_dissection(size_t n,
+                                               const std::vector<size_t> &cp,
+                                               const std::vector<size_t> &ri);
+
+  //! Returns the first index of the pattern of the k-th row of L in s,
+  //! i.e., the pattern is s[top], ..., s[n - 1], in topological order
+  static size_t ereach(size_t k, const std::vector<size_t> &cp,
+                       const std::vector<size_t> &ri,
+                       const std::vector<size_t> &parent,
+                       std::vector<size_t> &s, std::vector<size_t> &w);
+
+  void factorize(const std::vector<size_t> &cp, const std::vector<size_t> &ri,
+                 const std::vector<RealType> &vx);
+
+  ///
+  /// @brief      Checks that perm_ is a permutation, and that L is a lower
+  /// triangular factor, as laid out by factorize(), i.e., every column
+  /// starts with a positive diagonal, followed by its rows below the
+  /// diagonal in increasing order, and all values are finite.
+  ///
+  bool valid() const;
+
+public:
+  ///
+  /// @brief      Factorizes a symmetric positive definite matrix given in
+  /// compressed sparse columns, with both of its triangles.
+  ///
+  /// @param[in]  n     The dimension of the matrix
+  /// @param[in]  cp    The column pointers, of size n + 1
+  /// @param[in]  ri    The row indices of the non-zeros
+  /// @param[in]  vx    The values of the non-zeros
+  ///
+  /// @throw      std::runtime_error if the matrix is not positive definite
+  ///
+  sparse_cholesky(size_t n, const std::vector<size_t> &cp,
+                  const std::vector<size_t> &ri,
+                  const std::vector<RealType> &vx)
+      : n_(n) {
+    perm_ = nested_dissection(n, cp, ri);
+    factorize(cp, ri, vx);
+  }
+
+  sparse_cholesky(const sparse_cholesky &) = delete;
+  sparse_cholesky &operator=(const sparse_cholesky &) = delete;
+
+  size_t dims() const { return n_; }
+
+  //! Returns the number of non-zeros of L
+  size_t nnz() const { return lx_.size(); }
+
+  const std::vector<size_t> &perm() const { return perm_; }
+
+  //! Returns the log-determinant of Q
+  RealType log_det() const {
+    RealType res = 0;
+    for (size_t j = 0; j < n_; ++j)
+      res += std::log(lx_[lp_[j]]);
+    return 2 * res;
+  }
+
+  ///
+  /// @brief      y <- inv(L) y, for the m right-hand sides stored in the
+  /// rows of the m x n, column-major, y
+  ///
+  void solve_lower(RealType *y, size_t m = 1) const {
+    for (size_t j = 0; j < n_; ++j) {
+      RealType *yj = y + j * m;
+      const RealType d = lx_[lp_[j]];
+      for (size_t s = 0; s < m; ++s)
+        yj[s] /= d;
+
+      for (size_t p = lp_[j] + 1; p < lp_[j + 1]; ++p) {
+        RealType *yi = y + li_[p] * m;
+        const RealType l = lx_[p];
+        for (size_t s = 0; s < m; ++s)
+          yi[s] -= l * yj[s];
+      }
+    }
+  }
+
+  ///
+  /// @brief      y <- inv(L') y, for the m right-hand sides stored in the
+  /// rows of the m x n, column-major, y
+  ///
+  void solve_upper(RealType *y, size_t m = 1) const {
+    for (size_t j = n_; j-- > 0;) {
+      RealType *yj = y + j * m;
+      for (size_t p = lp_[j] + 1; p < lp_[j + 1]; ++p) {
+        const RealType *yi = y + li_[p] * m;
+        const RealType l = lx_[p];
+        for (size_t s = 0; s < m; ++s)
+          yj[s] -= l * yi[s];
+      }
+
+      const RealType d = lx_[lp_[j]];
+      for (size_t s = 0; s < m; ++s)
+        yj[s] /= d;
+    }
+  }
+
+  //! Writes the ordering and the factor to a binary snapshot
+  template <class charT, class traits>
+  void save(std::basic_ostream<charT, traits> &os) const {
+    snapshot::write_vector(os, perm_);
+    snapshot::write_vector(os, lp_);
+    snapshot::write_vector(os, li_);
+    snapshot::write_vector(os, lx_);
+  }
+
+  ///
+  /// @brief      Reads the factorization written by save(), and sets the
+  /// failbit of the stream if it is not a valid factor of dimension n
+  ///
+  template <class charT, class traits>
+  static std::shared_ptr<const sparse_cholesky>
+  load(std::basic_istream<charT, traits> &is, size_t n) {
+    std::shared_ptr<sparse_cholesky> f(new sparse_cholesky());
+    f->n_ = n;
+    snapshot::read_vector(is, f->perm_);
+    snapshot::read_vector(is, f->lp_);
+    snapshot::read_vector(is, f->li_);
+    snapshot::read_vector(is, f->lx_);
+
+    if (is && !f->valid())
+      is.setstate(std::ios_base::failbit);
+
+    return f;
+  }
+};
+
+template <class RealType>
+std::vector<size_t> sparse_cholesky<RealType>::nested_dissection(
+    size_t n, const std::vector<size_t> &cp, const std::vector<size_t> &ri) {
+  std::vector<size_t> perm(n);
+  if (n == 0)
+    return perm;
+
+  // part[v] labels the subgraph v belongs to, none once v is ordered, and
+  // level[v] is its level in the current breadth-first search
+  std::vector<size_t> part(n, 0), level(n, none);
+  size_t labels = 1;
+
+  // a subgraph, and the first position of its nodes in perm
+  struct subgraph {
+    std::vector<size_t> nodes;
+    size_t offset;
+    size_t label;
+  };
+
+  std::vector<subgraph> stack(1);
+  stack[0].nodes.resize(n);
+  for (size_t v = 0; v < n; ++v)
+    stack[0].nodes[v] = v;
+  stack[0].offset = 0;
+  stack[0].label = 0;
+
+  std::vector<size_t> queue;
+  queue.reserve(n);
+
+  // breadth-first search from root over the nodes labelled l, leaves the
+  // visited nodes in queue, by level, and returns the number of levels
+  auto bfs = [&](size_t root, size_t l) {
+    for (const size_t v : queue)
+      level[v] = none;
+    queue.clear();
+    queue.push_back(root);
+    level[root] = 0;
+
+    for (size_t q = 0; q < queue.size(); ++q) {
+      const size_t v = queue[q];
+      for (size_t p = cp[v]; p < cp[v + 1]; ++p) {
+        const size_t u = ri[p];
+        if (part[u] == l && level[u] == none) {
+          level[u] = level[v] + 1;
+          queue.push_back(u);
+        }
+      }
+    }
+    return level[queue.back()] + 1;
+  };
+
+  auto degree = [&](size_t v, size_t l) {
+    size_t d = 0;
+    for (size_t p = cp[v]; p < cp[v + 1]; ++p)
+      d += ri[p] != v && part[ri[p]] == l;
+    return d;
+  };
+
+  while (!stack.empty()) {
+    subgraph g = std::move(stack.back());
+    stack.pop_back();
+
+    const size_t l = g.label;
+    const size_t size = g.nodes.size();
+    size_t depth = bfs(g.nodes[0], l);
+
+    // orders the connected components separately
+    if (queue.size() < size) {
+      const size_t label = labels++;
+      for (const size_t v : queue)
+        part[v] = label;
+
+      subgraph rest{{}, g.offset + queue.size(), l};
+      for (const size_t v : g.nodes)
+        if (part[v] == l)
+          rest.nodes.push_back(v);
+
+      stack.push_back(std::move(rest));
+      stack.push_back(subgraph{queue, g.offset, label});
+      continue;
+    }
+
+    // pseudo-peripheral root, i.e., the end of a long path of the subgraph
+    while (true) {
+      size_t cand = queue.back(), cand_degree = degree(cand, l);
+      for (size_t q = queue.size() - 1;
+           q-- > 0 && level[queue[q]] + 1 == depth;) {
+        const size_t d = degree(queue[q], l);
+        if (d < cand_degree) {
+          cand = queue[q];
+          cand_degree = d;
+        }
+      }
+
+      const size_t next_depth = bfs(cand, l);
+      if (next_depth <= depth)
+        break;
+      depth = next_depth;
+    }
+
+    // small subgraphs, and those without a separating level, are ordered by
+    // their reversed levels
+    if (size <= leaf_size || depth < 3) {
+      for (size_t q = 0; q < size; ++q) {
+        perm[g.offset + size - 1 - q] = queue[q];
+        part[queue[q]] = none;
+      }
+      continue;
+    }
+
+    // the separator is the part of the median level adjacent to the next
+    // one, it splits the subgraph into the levels above and below it
+    size_t m = 0;
+    for (size_t count = 0; m + 1 < depth; ++m) {
+      size_t q = count;
+      while (q < size && level[queue[q]] == m)
+        ++q;
+      if (2 * q >= size)
+        break;
+      count = q;
+    }
+    m = std::min(std::max(m, size_t(1)), depth - 2);
+
+    subgraph a{{}, g.offset, labels++}, b{{}, 0, labels++};
+    std::vector<size_t> sep;
+    for (const size_t v : queue) {
+      if (level[v] > m) {
+        b.nodes.push_back(v);
+        continue;
+      }
+
+      bool adjacent = false;
+      for (size_t p = cp[v]; level[v] == m && !adjacent && p < cp[v + 1]; ++p)
+        adjacent = part[ri[p]] == l && level[ri[p]] == m + 1;
+
+      if (adjacent)
+        sep.push_back(v);
+      else
+        a.nodes.push_back(v);
+    }
+
+    b.offset = g.offset + a.nodes.size();
+    const size_t sep_offset = b.offset + b.nodes.size();
+    for (size_t q = 0; q < sep.size(); ++q) {
+      perm[sep_offset + q] = sep[q];
+      part[sep[q]] = none;
+    }
+
+    for (const size_t v : a.nodes)
+      part[v] = a.label;
+    for (const size_t v : b.nodes)
+      part[v] = b.label;
+
+    stack.push_back(std::move(b));
+    stack.push_back(std::move(a));
+  }
+
+  return perm;
+}
+
+template <class RealType> bool sparse_cholesky<RealType>::valid() const {
+  const size_t n = n_;
+  if (perm_.size() != n || lp_.size() != n + 1 || lp_[0] != 0 ||
+      lp_[n] != li_.size() || li_.size() != lx_.size())
+    return false;
+
+  std::vector<char> seen(n, 0);
+  for (const size_t v : perm_) {
+    if (v >= n || seen[v])
+      return false;
+    seen[v] = 1;
+  }
+
+  for (size_t j = 0; j < n; ++j) {
+    if (lp_[j] >= lp_[j + 1] || lp_[j + 1] > li_.size())
+      return false;
+
+    const size_t d = lp_[j];
+    if (li_[d] != j || !(lx_[d] > 0) || !std::isfinite(lx_[d]))
+      return false;
+
+    for (size_t p = d + 1; p < lp_[j + 1]; ++p)
+      if (li_[p] <= li_[p - 1] || li_[p] >= n || !std::isfinite(lx_[p]))
+        return false;
+  }
+
+  return true;
+}
+
+template <class RealType>
+size_t sparse_cholesky<RealType>::ereach(size_t k,
+                                         const std::vector<size_t> &cp,
+                                         const std::vector<size_t> &ri,
+                                         const std::vector<size_t> &parent,
+                                         std::vector<size_t> &s,
+                                         std::vector<size_t> &w) {
+  size_t top = s.size();
+  w[k] = k;
+
+  for (size_t p = cp[k]; p < cp[k + 1]; ++p) {
+    size_t i = ri[p];
+    if (i > k)
+      continue;
+
+    // climb the elimination tree up to a marked node, it ends at k
+    size_t len = 0;
+    for (; w[i] != k; i = parent[i]) {
+      s[len++] = i;
+      w[i] = k;
+    }
+
+    while (len > 0)
+      s[--top] = s[--len];
+  }
+
+  return top;
+}
+
+template <class RealType>
+void sparse_cholesky<RealType>::factorize(const std::vector<size_t> &cp,
+                                          const std::vector<size_t> &ri,
+                                          const std::vector<RealType> &vx) {
+  const size_t n = n_;
+
+  std::vector<size_t> pinv(n);
+  for (size_t k = 0; k < n; ++k)
+    pinv[perm_[k]] = k;
+
+  // upper triangle of C = P Q P', in compressed sparse columns
+  std::vector<size_t> ccp(n + 1, 0), cri;
+  std::vector<RealType> cvx;
+  for (size_t j = 0; j < n; ++j)
+    for (size_t p = cp[j]; p < cp[j + 1]; ++p)
+      if (pinv[ri[p]] <= pinv[j])
+        ++ccp[pinv[j] + 1];
+  for (size_t k = 0; k < n; ++k)
+    ccp[k + 1] += ccp[k];
+
+  cri.resize(ccp[n]);
+  cvx.resize(ccp[n]);
+  std::vector<size_t> next(ccp.begin(), ccp.end() - 1);
+  for (size_t j = 0; j < n; ++j)
+    for (size_t p = cp[j]; p < cp[j + 1]; ++p)
+      if (pinv[ri[p]] <= pinv[j]) {
+        const size_t q = next[pinv[j]]++;
+        cri[q] = pinv[ri[p]];
+        cvx[q] = vx[p];
+      }
+
+  // elimination tree
+  std::vector<size_t> parent(n, none), ancestor(n, none);
+  for (size_t k = 0; k < n; ++k)
+    for (size_t p = ccp[k]; p < ccp[k + 1]; ++p)
+      for (size_t i = cri[p]; i != none && i < k;) {
+        const size_t inext = ancestor[i];
+        ancestor[i] = k;
+        if (inext == none)
+          parent[i] = k;
+        i = inext;
+      }
+
+  // column counts, from the patterns of the rows of L
+  std::vector<size_t> s(n), w(n, none);
+  lp_.assign(n + 1, 0);
+  for (size_t k = 0; k < n; ++k) {
+    ++lp_[k + 1];
+    for (size_t top = ereach(k, ccp, cri, parent, s, w); top < n; ++top)
+      ++lp_[s[top] + 1];
+  }
+  for (size_t k = 0; k < n; ++k)
+    lp_[k + 1] += lp_[k];
+
+  li_.resize(lp_[n]);
+  lx_.resize(lp_[n]);
+
+  // up-looking numeric factorization, the k-th row of L at a time
+  std::vector<RealType> x(n, 0);
+  std::vector<size_t> c(lp_.begin(), lp_.end() - 1);
+  std::fill(w.begin(), w.end(), none);
+
+  for (size_t k = 0; k < n; ++k) {
+    size_t top = ereach(k, ccp, cri, parent, s, w);
+
+    for (size_t p = ccp[k]; p < ccp[k + 1]; ++p)
+      x[cri[p]] += cvx[p];
+    RealType d = x[k];
+    x[k] = 0;
+
+    for (; top < n; ++top) {
+      const size_t i = s[top];
+      const RealType lki = x[i] / lx_[lp_[i]];
+      x[i] = 0;
+      for (size_t p = lp_[i] + 1; p < c[i]; ++p)
+        x[li_[p]] -= lx_[p] * lki;
+      d -= lki * lki;
+
+      const size_t p = c[i]++;
+      li_[p] = k;
+      lx_[p] = lki;
+    }
+
+    if (!(d > 0))
+      throw std::runtime_error(
+          "chol(): precision matrix is not positive definite");
+
+    const size_t p = c[k]++;
+    li_[p] = k;
+    lx_[p] = std::sqrt(d);
+  }
+}
+
+} // namespace detail
+
+} // namespace baaraan
+
+#endif // BAARAAN_SPARSE_CHOLESKY_H
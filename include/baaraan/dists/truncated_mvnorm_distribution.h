@@ -13,10 +13,15 @@
 #define BAARAAN_TRUNCATED_MVNORM_DISTRIBUTION_H
 
 #include "boost/math/distributions/normal.hpp"
+#include <algorithm>
 #include <armadillo>
 #include <iostream>
+#include <memory>
 #include <random>
 
+#include "compiled.h"
+#include "snapshot.h"
+
 using boost::math::normal;
 
 namespace baaraan {
@@ -35,6 +40,29 @@ public:
   typedef arma::Col<RealType> vector_type;
   typedef arma::Mat<RealType> matrix_type;
 
+private:
+  //! The structure of the full conditionals, see param_type
+  struct conditionals_type {
+    matrix_type weights;
+    vector_type sd;
+  };
+
+public:
+  ///
+  /// @brief      Truncated Multivariate Normal Distribution Parameter Type
+  ///
+  /// Besides the parameters, it holds the structure of the full conditional
+  /// distributions used by the Gibbs sampler. They are derived from the
+  /// precision matrix, Q, once, i.e.,
+  ///
+  ///   E[x_i | x_-i] = mu_i + cond_weights.col(i)' (x - mu),
+  ///   sd[x_i | x_-i] = 1 / sqrt(Q_ii),
+  ///
+  /// where cond_weights(j, i) = -Q_ji / Q_ii for j != i, and zero otherwise.
+  ///
+  /// The conditionals are shared between copies, and also identify the
+  /// parameters a context's Gibbs chain is running on.
+  ///
   class param_type {
     size_t dims_;
     vector_type means_;
@@ -42,6 +70,26 @@ public:
     vector_type lowers_;
     vector_type uppers_;
 
+    std::shared_ptr<const conditionals_type> cond_;
+
+    void compute_conditionals() {
+      matrix_type q = arma::inv_sympd(sigma_);
+      vector_type qd = q.diag();
+
+      conditionals_type c;
+      c.weights = q.each_row() / qd.t();
+      c.weights *= -1;
+      c.weights.diag().zeros();
+
+      c.sd = 1 / arma::sqrt(qd);
+
+      cond_ = std::make_shared<const conditionals_type>(std::move(c));
+    }
+
+    param_type() : dims_(0) {}
+
+    friend class truncated_mvnorm_distribution;
+
   public:
     typedef truncated_mvnorm_distribution distribution_type;
 
@@ -51,29 +99,80 @@ public:
 
       dims_ = means.n_elem;
 
-      // @todo Check if lower is actually lower than the upper
-
       // Checking whether dimensions matches
       if (lowers_.n_elem != dims_ || uppers_.n_elem != dims_)
         throw std::length_error("Check your arrays size");
 
+      if (arma::any(lowers_ > uppers_))
+        throw std::logic_error("Lower bounds should not exceed upper bounds.");
+
       if (!sigma.is_symmetric() || !sigma.is_square())
         throw std::logic_error("Covariance matrix is not symmetric.");
+
+      compute_conditionals();
     }
 
     size_t dims() const { return dims_; }
 
-    vector_type means() const { return means_; }
+    const vector_type &means() const { return means_; }
 
-    matrix_type sigma() const { return sigma_; }
+    const matrix_type &sigma() const { return sigma_; }
 
-    vector_type lowers() const { return lowers_; }
+    const vector_type &lowers() const { return lowers_; }
 
-    vector_type uppers() const { return uppers_; }
+    const vector_type &uppers() const { return uppers_; }
+
+    //! Returns the weights of the conditional means, column i belongs to x_i
+    const matrix_type &cond_weights() const { return cond_->weights; }
+
+    //! Returns the conditional standard deviations
+    const vector_type &cond_sd() const { return cond_->sd; }
+
+    ///
+    /// @brief      Writes the parameters, and the conditional structure, to a
+    /// binary snapshot.
+    ///
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_vector(os, means_);
+      snapshot::write_matrix(os, sigma_);
+      snapshot::write_vector(os, lowers_);
+      snapshot::write_vector(os, uppers_);
+      snapshot::write_matrix(os, cond_weights());
+      snapshot::write_vector(os, cond_sd());
+    }
+
+    ///
+    /// @brief      Reads the parameters written by save(), without
+    /// recomputing the conditional structure.
+    ///
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      param_type p;
+      conditionals_type c;
+
+      snapshot::read_vector(is, p.means_);
+      snapshot::read_matrix(is, p.sigma_);
+      snapshot::read_vector(is, p.lowers_);
+      snapshot::read_vector(is, p.uppers_);
+      snapshot::read_matrix(is, c.weights);
+      snapshot::read_vector(is, c.sd);
+
+      p.dims_ = p.means_.n_elem;
+      if (p.sigma_.n_rows != p.dims_ || p.sigma_.n_cols != p.dims_ ||
+          p.lowers_.n_elem != p.dims_ || p.uppers_.n_elem != p.dims_ ||
+          c.weights.n_rows != p.dims_ || c.weights.n_cols != p.dims_ ||
+          c.sd.n_elem != p.dims_)
+        is.setstate(std::ios_base::failbit);
+
+      p.cond_ = std::make_shared<const conditionals_type>(std::move(c));
+
+      return p;
+    }
 
     friend bool operator==(const param_type &x, const param_type &y) {
       return arma::approx_equal(x.means_, y.means_, "absdiff", 0.001) &&
-             arma::approx_equal(x.covs_, y.covs_, "absdiff", 0.001) &&
+             arma::approx_equal(x.sigma_, y.sigma_, "absdiff", 0.001) &&
              arma::approx_equal(x.lowers_, y.lowers_, "absdiff", 0.001) &&
              arma::approx_equal(x.uppers_, y.uppers_, "absdiff", 0.001);
     }
@@ -83,29 +182,39 @@ public:
     }
   };
 
-private:
-  std::uniform_real_distribution<> uniform{};
-  param_type p_;
+  ///
+  /// @brief      Position of the Gibbs chain, and its inversion uniforms
+  ///
+  /// Every context runs its own Gibbs chain, so threads sharing the
+  /// distribution draw from independent chains. The chain restarts whenever
+  /// it is passed different parameters.
+  ///
+  struct context_type {
+    std::uniform_real_distribution<RealType> uniform;
 
-  arma::Mat<RealType> sub1(arma::Mat<RealType> x, int i) {
-    x.shed_col(i);
-    x.shed_row(i);
-    return x;
-  }
+    //! Current position of the Gibbs chain
+    vector_type x;
+    vector_type diff;
 
-  arma::Mat<RealType> sub2(arma::Mat<RealType> x, int a, int b) {
-    x.shed_col(b);
-    return (x.row(a));
-  }
+    //! Conditionals of the parameters the chain is running on
+    std::shared_ptr<const conditionals_type> chain_cond;
 
-  arma::Col<RealType> negSubCol(arma::Col<RealType> x, int i) {
-    x.shed_row(i);
-    return (x);
-  }
+    void reset() {
+      uniform.reset();
+      x.reset();
+      chain_cond.reset();
+    }
+  };
 
-  arma::Row<RealType> negSubRow(arma::Row<RealType> x, int i) {
-    x.shed_col(i);
-    return (x);
+private:
+  context_type ctx_;
+
+  param_type p_;
+
+  //! Returns what identifies the parameters of a chain, see context_type
+  static const std::shared_ptr<const conditionals_type> &
+  conditionals(const param_type &p) {
+    return p.cond_;
   }
 
 public:
@@ -131,14 +240,26 @@ public:
   ///
   explicit truncated_mvnorm_distribution(const param_type &p) : p_(p) {}
 
-  void reset() { uniform.reset(); };
+  void reset() { ctx_.reset(); };
 
   // generating functions
   template <class URNG> vector_type operator()(URNG &g) {
-    return (*this)(g, p_);
+    return (*this)(g, ctx_, p_);
   }
 
-  template <class URNG> vector_type operator()(URNG &g, const param_type &p);
+  template <class URNG> vector_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
+  }
+
+  template <class URNG>
+  vector_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
 
   // property functions
   vector_type means() const { return p_.means(); }
@@ -165,80 +286,110 @@ public:
     return !(x == y);
   }
 
+  ///
+  /// @brief      Writes a binary snapshot of the distribution, including the
+  /// current position of its Gibbs chain, see snapshot.h
+  ///
   template <class charT, class traits>
   friend std::basic_ostream<charT, traits> &
   operator<<(std::basic_ostream<charT, traits> &os,
-             const truncated_mvnorm_distribution &means);
+             const truncated_mvnorm_distribution &x) {
+    snapshot::write_header(os, snapshot::kind::truncated_mvnorm,
+                           sizeof(RealType));
+    x.p_.save(os);
+    snapshot::write_state(os, x.ctx_.uniform);
+    snapshot::write_vector(os, x.ctx_.x);
+    return os;
+  }
 
+  ///
+  /// @brief      Restores a distribution from its binary snapshot, so that
+  /// its Gibbs chain resumes exactly where it was. The distribution is left
+  /// unchanged if the snapshot cannot be read.
+  ///
   template <class charT, class traits>
   friend std::basic_istream<charT, traits> &
   operator>>(std::basic_istream<charT, traits> &is,
-             truncated_mvnorm_distribution &means);
+             truncated_mvnorm_distribution &x) {
+    if (!snapshot::read_header(is, snapshot::kind::truncated_mvnorm,
+                               sizeof(RealType)))
+      return is;
+
+    param_type p = param_type::load(is);
+    std::uniform_real_distribution<RealType> uniform;
+    vector_type chain;
+    snapshot::read_state(is, uniform);
+    snapshot::read_vector(is, chain);
+
+    if (!chain.is_empty() && chain.n_elem != p.dims())
+      is.setstate(std::ios_base::failbit);
+
+    if (is) {
+      x.p_ = p;
+      x.ctx_.uniform = uniform;
+      x.ctx_.x = chain;
+      x.ctx_.chain_cond = chain.is_empty() ? nullptr : conditionals(p);
+    }
+    return is;
+  }
 };
 
-// Implementation of rejection algorithm
+///
+/// Implementation of the Gibbs sampler. Every call runs one sweep over all
+/// coordinates, starting from the current position of the context's chain,
+/// and returns the new position. The chain starts at the means, projected
+/// into the truncation bounds, and starts over there whenever the context
+/// is passed different parameters.
+///
 template <class RealType>
 template <class _URNG>
 typename truncated_mvnorm_distribution<RealType>::vector_type
 truncated_mvnorm_distribution<RealType>::operator()(
-    _URNG &g, const truncated_mvnorm_distribution<RealType>::param_type &p) {
-
-  auto n{1};
-  auto d = p.dims();
-  arma::Mat<RealType> trace;
-  trace.zeros(n, d); // trace of MCMC chain
-
-  // draw from U(0,1)
-  arma::Col<RealType> U(n * d);
-  U.imbue([&]() { return uniform(g); });
-
-  auto l{0}; // iterator for U
-
-  // calculate conditional standard deviations
-  arma::Col<RealType> sd(d);
-  arma::Cube<RealType> P;
-  P.zeros(1, d - 1, d);
-
-  for (int i = 0; i < d; i++) {
-    // partitioning of sigma
-    arma::Mat<RealType> Sigma = sub1(p.sigma(), i);
-    double sigma_ii = p.sigma()(i, i);
-    arma::Row<RealType> Sigma_i = sub2(p.sigma(), i, i);
-
-    P.slice(i) = Sigma_i * Sigma.i();
-    double p_i = arma::as_scalar(P.slice(i) * Sigma_i.t());
-    sd(i) = sqrt(sigma_ii - p_i);
+    _URNG &g, context_type &ctx,
+    const truncated_mvnorm_distribution<RealType>::param_type &p) const {
+
+  const size_t d = p.dims();
+  const vector_type &mu = p.means();
+  vector_type &x_ = ctx.x;
+  vector_type &diff = ctx.diff;
+
+  if (ctx.chain_cond != conditionals(p) || x_.n_elem != d) {
+    x_ = mu;
+    for (size_t i = 0; i < d; ++i)
+      x_(i) = std::min(std::max(x_(i), p.lowers()(i)), p.uppers()(i));
+    ctx.chain_cond = conditionals(p);
   }
 
-  arma::Col<RealType> x = p.means();
-
-  // run Gibbs sampler for specified chain length (MCMC chain of n samples)
-  for (int j = 0; j < n; j++) {
-
-    // sample all conditional distributions
-    for (int i = 0; i < d; i++) {
-
-      // calculation of conditional expectation and conditional variance
-      arma::Row<RealType> slice_i = P.slice(i);
-      arma::Col<RealType> slice_i_times = slice_i * (negSubCol(x, i) - negSubCol(x, i));
-      double slice_i_times_double = arma::as_scalar(slice_i_times);
-      double mu_i = p.means()(i) + slice_i_times_double;
+  diff = x_ - mu;
 
-      // transformation
-      double Fa = cdf(normal{mu_i, sd(i)}, p.lowers()(i));
-      double Fb = cdf(normal{mu_i, sd(i)}, p.uppers()(i));
+  for (size_t i = 0; i < d; ++i) {
+    // conditional expectation and standard deviation of x_i given the rest
+    double mu_i = mu(i) + arma::dot(p.cond_weights().col(i), diff);
+    double sd_i = p.cond_sd()(i);
 
-      x(i) = mu_i + sd(i) * quantile(normal{0, 1}, U(l) * (Fb - Fa) + Fa);
+    // transformation
+    double Fa = cdf(normal{mu_i, sd_i}, p.lowers()(i));
+    double Fb = cdf(normal{mu_i, sd_i}, p.uppers()(i));
 
-      l = l + 1;
-    }
-
-    trace.row(j) = x.t();
+    x_(i) = mu_i +
+            sd_i * quantile(normal{0, 1}, ctx.uniform(g) * (Fb - Fa) + Fa);
+    diff(i) = x_(i) - mu(i);
   }
 
-  return trace.t();
+  return x_;
 }
 
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_TRUNCATED_MVNORM_INSTANCES(EXT)                               \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT,                          \
+                        truncated_mvnorm_distribution)                        \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             truncated_mvnorm_distribution, vector_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_TRUNCATED_MVNORM_INSTANCES(extern)
+#endif
+
 } // namespace baaraan
 
 #endif // BAARAAN_TRUNCATED_MVNORM_DISTRIBUTION_H
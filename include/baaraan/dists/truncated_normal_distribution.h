@@ -13,6 +13,9 @@
 #include <iostream>
 #include <random>
 
+#include "compiled.h"
+#include "snapshot.h"
+
 using boost::math::normal;
 
 namespace baaraan {
@@ -50,6 +53,26 @@ public:
 
     result_type upper() const { return upper_; }
 
+    //! Writes the parameters to a binary snapshot
+    template <class charT, class traits>
+    void save(std::basic_ostream<charT, traits> &os) const {
+      snapshot::write_pod(os, mean_);
+      snapshot::write_pod(os, stddev_);
+      snapshot::write_pod(os, lower_);
+      snapshot::write_pod(os, upper_);
+    }
+
+    //! Reads the parameters written by save()
+    template <class charT, class traits>
+    static param_type load(std::basic_istream<charT, traits> &is) {
+      result_type mean{0}, stddev{1}, lower{0}, upper{0};
+      snapshot::read_pod(is, mean);
+      snapshot::read_pod(is, stddev);
+      snapshot::read_pod(is, lower);
+      snapshot::read_pod(is, upper);
+      return param_type(mean, stddev, lower, upper);
+    }
+
     friend bool operator==(const param_type &x, const param_type &y) {
       return x.mean_ == y.mean_ && x.stddev_ == y.stddev_ &&
              x.lower_ == y.lower_ && x.upper_ == y.upper_;
@@ -60,10 +83,17 @@ public:
     }
   };
 
+  //! Uniform inverted through the normal CDF between the bounds
+  struct context_type {
+    std::uniform_real_distribution<> uniform;
+
+    void reset() { uniform.reset(); }
+  };
+
 private:
   param_type p_;
   normal unit_normal_;
-  std::uniform_real_distribution<> uniform_;
+  context_type ctx_;
 
 public:
   ///
@@ -89,14 +119,26 @@ public:
   ///
   explicit truncated_normal_distribution(const param_type &p) : p_(p) {}
 
-  void reset() { uniform_.reset(); }
+  void reset() { ctx_.reset(); }
 
   // generating functions
   template <class URNG> result_type operator()(URNG &g) {
-    return (*this)(g, p_);
+    return (*this)(g, ctx_, p_);
+  }
+
+  template <class URNG> result_type operator()(URNG &g, const param_type &p) {
+    return (*this)(g, ctx_, p);
+  }
+
+  // reentrant generating functions, see context_type
+  template <class URNG>
+  result_type operator()(URNG &g, context_type &ctx) const {
+    return (*this)(g, ctx, p_);
   }
 
-  template <class URNG> result_type operator()(URNG &g, const param_type &p);
+  template <class URNG>
+  result_type operator()(URNG &g, context_type &ctx,
+                         const param_type &p) const;
 
   // property functions
   result_type mean() const { return p_.mean(); }
@@ -135,15 +177,15 @@ public:
 template <class RealType>
 template <class URNG>
 RealType
-truncated_normal_distribution<RealType>::operator()(URNG &g,
-                                                    const param_type &parm) {
+truncated_normal_distribution<RealType>::operator()(
+    URNG &g, context_type &ctx, const param_type &parm) const {
   double alpha = (parm.lower() - parm.mean()) / parm.stddev();
   double beta = (parm.upper() - parm.mean()) / parm.stddev();
 
   double alpha_cdf = cdf(unit_normal_, alpha);
   double beta_cdf = cdf(unit_normal_, beta);
 
-  double u = uniform_(g);
+  double u = ctx.uniform(g);
   double xi_cdf = alpha_cdf + u * (beta_cdf - alpha_cdf);
   double xi = quantile(unit_normal_, xi_cdf);
 
@@ -152,6 +194,55 @@ truncated_normal_distribution<RealType>::operator()(URNG &g,
   return x;
 }
 
+///
+/// @brief      Writes a binary snapshot of the distribution, see snapshot.h
+///
+template <class _CharT, class _Traits, class _RT>
+std::basic_ostream<_CharT, _Traits> &
+operator<<(std::basic_ostream<_CharT, _Traits> &os,
+           const truncated_normal_distribution<_RT> &x) {
+  snapshot::write_header(os, snapshot::kind::truncated_normal, sizeof(_RT));
+  x.p_.save(os);
+  snapshot::write_state(os, x.ctx_.uniform);
+  return os;
+}
+
+///
+/// @brief      Restores a distribution from its binary snapshot. The
+/// distribution is left unchanged if the snapshot cannot be read.
+///
+template <class _CharT, class _Traits, class _RT>
+std::basic_istream<_CharT, _Traits> &
+operator>>(std::basic_istream<_CharT, _Traits> &is,
+           truncated_normal_distribution<_RT> &x) {
+  typedef typename truncated_normal_distribution<_RT>::param_type param_type;
+
+  if (!snapshot::read_header(is, snapshot::kind::truncated_normal,
+                             sizeof(_RT)))
+    return is;
+
+  param_type p = param_type::load(is);
+  std::uniform_real_distribution<> uniform;
+  snapshot::read_state(is, uniform);
+
+  if (is) {
+    x.p_ = p;
+    x.ctx_.uniform = uniform;
+  }
+  return is;
+}
+
+//! Explicit instantiations provided by baaraan::compiled, see compiled.h
+#define BAARAAN_TRUNCATED_NORMAL_INSTANCES(EXT)                               \
+  BAARAAN_FOR_EACH_REAL(BAARAAN_CLASS_INSTANCE, EXT,                          \
+                        truncated_normal_distribution)                        \
+  BAARAAN_FOR_EACH_REAL_URNG(BAARAAN_SAMPLER_INSTANCE, EXT,                   \
+                             truncated_normal_distribution, result_type)
+
+#ifdef BAARAAN_USE_COMPILED
+BAARAAN_TRUNCATED_NORMAL_INSTANCES(extern)
+#endif
+
 } // namespace baaraan
 
 #endif // BAARAAN_TRUNCATED_NORMAL_DISTRIBUTION_H
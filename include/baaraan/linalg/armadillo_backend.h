@@ -0,0 +1,123 @@
+///
+/// @file
+/// This file contains the Armadillo linear algebra backend, the default
+/// backend of the distributions.
+///
+/// @defgroup LinearAlgebraBackends Linear Algebra Backends
+/// @brief List of supported linear algebra backends
+///
+/// A backend is a stateless policy class that defines the `matrix_type` and
+/// `vector_type` of a distribution, and the handful of dense operations its
+/// sampler needs, i.e., Cholesky factorization, triangular products and
+/// inversion, and raw access to the column-major memory of its containers.
+/// Distributions taking a `Backend` template parameter only touch their
+/// matrices through it, so their draws are returned in the backend's own
+/// containers, without any conversion.
+///
+
+#ifndef BAARAAN_ARMADILLO_BACKEND_H
+#define BAARAAN_ARMADILLO_BACKEND_H
+
+#include <armadillo>
+#include <cstddef>
+
+namespace baaraan {
+
+namespace linalg {
+
+///
+/// @brief      Armadillo Linear Algebra Backend
+///
+/// @tparam     RealType  Indicates the type of the matrix elements
+///
+/// @ingroup    LinearAlgebraBackends
+///
+template <class RealType> struct armadillo_backend {
+  typedef RealType value_type;
+  typedef arma::Mat<RealType> matrix_type;
+  typedef arma::Col<RealType> vector_type;
+
+  // shape and memory
+
+  static size_t rows(const matrix_type &a) { return a.n_rows; }
+  static size_t cols(const matrix_type &a) { return a.n_cols; }
+  static size_t rows(const vector_type &x) { return x.n_elem; }
+  static size_t cols(const vector_type &) { return 1; }
+
+  static RealType *data(matrix_type &a) { return a.memptr(); }
+  static const RealType *data(const matrix_type &a) { return a.memptr(); }
+
+  static void resize(matrix_type &a, size_t r, size_t c) { a.set_size(r, c); }
+  static void resize(vector_type &x, size_t r, size_t = 1) { x.set_size(r); }
+
+  static vector_type constant(size_t n, RealType v) {
+    return vector_type(n).fill(v);
+  }
+
+  // predicates
+
+  static bool is_symmetric(const matrix_type &a) {
+    return a.is_square() && a.is_symmetric();
+  }
+
+  static bool approx_equal(const matrix_type &a, const matrix_type &b,
+                           RealType tol) {
+    return arma::approx_equal(a, b, "absdiff", tol);
+  }
+
+  // factorizations
+
+  //! Returns the lower Cholesky factor of a, throws std::runtime_error if a
+  //! is not positive definite
+  static matrix_type cholesky(const matrix_type &a) {
+    return arma::chol(a, "lower");
+  }
+
+  //! Returns the inverse of the lower triangular matrix l
+  static matrix_type inverse_lower(const matrix_type &l) {
+    return arma::inv(arma::trimatl(l));
+  }
+
+  //! Returns a' a
+  static matrix_type crossprod(const matrix_type &a) { return a.t() * a; }
+
+  //! Returns a' b
+  static matrix_type crossprod(const matrix_type &a, const matrix_type &b) {
+    return a.t() * b;
+  }
+
+  //! Returns log(det(l l')) of the lower triangular matrix l
+  static RealType log_det_lower(const matrix_type &l) {
+    return 2 * arma::accu(arma::log(arma::diagvec(l)));
+  }
+
+  // products
+
+  ///
+  /// @brief      x <- l x, for a lower triangular l and every column of x
+  ///
+  /// The factors produced by cholesky() hold explicit zeros above their
+  /// diagonal, so Armadillo's general product is used, avoiding the dense
+  /// copy that `trimatl(l)` would make. Since x aliases the product, it is
+  /// evaluated into a new buffer, which then replaces the memory of x; see
+  /// blas_backend for a TRMM in place.
+  ///
+  static void lower_mult(const matrix_type &l, matrix_type &x) { x = l * x; }
+
+  //! y <- y + a x
+  static void mult_add(const matrix_type &a, const vector_type &x,
+                       vector_type &y) {
+    y += a * x;
+  }
+
+  //! x <- x + mu, for every column of x
+  static void add_cols(matrix_type &x, const vector_type &mu) {
+    x.each_col() += mu;
+  }
+};
+
+} // namespace linalg
+
+} // namespace baaraan
+
+#endif // BAARAAN_ARMADILLO_BACKEND_H
@@ -0,0 +1,282 @@
+///
+/// @file
+/// This file contains the plain BLAS/LAPACK linear algebra backend, see
+/// armadillo_backend.h for the interface of a backend.
+///
+/// Vectors are std::vector, and matrices are column-major buffers, i.e.,
+/// blas_matrix, that can be handed to any BLAS routine as they are. The
+/// backend calls CBLAS and LAPACKE directly, so the project has to link to
+/// an implementation providing both, e.g., OpenBLAS or MKL.
+///
+
+#ifndef BAARAAN_BLAS_BACKEND_H
+#define BAARAAN_BLAS_BACKEND_H
+
+#include <cblas.h>
+#include <lapacke.h>
+
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+
+namespace baaraan {
+
+namespace linalg {
+
+///
+/// @brief      A column-major matrix, stored in a contiguous buffer
+///
+template <class RealType> struct blas_matrix {
+  size_t n_rows = 0;
+  size_t n_cols = 0;
+  std::vector<RealType> mem;
+
+  blas_matrix() = default;
+
+  blas_matrix(size_t r, size_t c) : n_rows(r), n_cols(c), mem(r * c) {}
+
+  //! Constructs a matrix from its rows, for convenience
+  blas_matrix(std::initializer_list<std::initializer_list<RealType>> rows)
+      : n_rows(rows.size()), n_cols(rows.size() ? rows.begin()->size() : 0),
+        mem(n_rows * n_cols) {
+    size_t i = 0;
+    for (const auto &row : rows) {
+      size_t j = 0;
+      for (const RealType v : row)
+        (*this)(i, j++) = v;
+      ++i;
+    }
+  }
+
+  RealType &operator()(size_t i, size_t j) { return mem[i + j * n_rows]; }
+
+  const RealType &operator()(size_t i, size_t j) const {
+    return mem[i + j * n_rows];
+  }
+};
+
+namespace detail {
+
+// Overloads dispatching to the single and double precision routines
+
+inline int potrf(int n, float *a) {
+  return LAPACKE_spotrf(LAPACK_COL_MAJOR, 'L', n, a, n);
+}
+
+inline int potrf(int n, double *a) {
+  return LAPACKE_dpotrf(LAPACK_COL_MAJOR, 'L', n, a, n);
+}
+
+inline int trtri(int n, float *a) {
+  return LAPACKE_strtri(LAPACK_COL_MAJOR, 'L', 'N', n, a, n);
+}
+
+inline int trtri(int n, double *a) {
+  return LAPACKE_dtrtri(LAPACK_COL_MAJOR, 'L', 'N', n, a, n);
+}
+
+inline void trmv(int n, const float *l, float *x) {
+  cblas_strmv(CblasColMajor, CblasLower, CblasNoTrans, CblasNonUnit, n, l, n,
+              x, 1);
+}
+
+inline void trmv(int n, const double *l, double *x) {
+  cblas_dtrmv(CblasColMajor, CblasLower, CblasNoTrans, CblasNonUnit, n, l, n,
+              x, 1);
+}
+
+inline void trmm(int n, int m, const float *l, float *x) {
+  cblas_strmm(CblasColMajor, CblasLeft, CblasLower, CblasNoTrans,
+              CblasNonUnit, n, m, 1.f, l, n, x, n);
+}
+
+inline void trmm(int n, int m, const double *l, double *x) {
+  cblas_dtrmm(CblasColMajor, CblasLeft, CblasLower, CblasNoTrans,
+              CblasNonUnit, n, m, 1., l, n, x, n);
+}
+
+//! c <- a' b, for a k x m matrix a and a k x n matrix b
+inline void gemm_tn(int m, int n, int k, const float *a, const float *b,
+                    float *c) {
+  cblas_sgemm(CblasColMajor, CblasTrans, CblasNoTrans, m, n, k, 1.f, a, k, b,
+              k, 0.f, c, m);
+}
+
+inline void gemm_tn(int m, int n, int k, const double *a, const double *b,
+                    double *c) {
+  cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans, m, n, k, 1., a, k, b,
+              k, 0., c, m);
+}
+
+//! y <- y + a x, for an m x n matrix a
+inline void gemv(int m, int n, const float *a, const float *x, float *y) {
+  cblas_sgemv(CblasColMajor, CblasNoTrans, m, n, 1.f, a, m, x, 1, 1.f, y, 1);
+}
+
+inline void gemv(int m, int n, const double *a, const double *x, double *y) {
+  cblas_dgemv(CblasColMajor, CblasNoTrans, m, n, 1., a, m, x, 1, 1., y, 1);
+}
+
+//! Zeros the strictly upper triangle left untouched by LAPACK
+template <class RealType> void zero_upper(blas_matrix<RealType> &a) {
+  for (size_t j = 1; j < a.n_cols; ++j)
+    for (size_t i = 0; i < j && i < a.n_rows; ++i)
+      a(i, j) = 0;
+}
+
+} // namespace detail
+
+///
+/// @brief      Plain BLAS/LAPACK Linear Algebra Backend
+///
+/// @tparam     RealType  Indicates the type of the matrix elements, either
+/// float or double
+///
+/// @ingroup    LinearAlgebraBackends
+///
+template <class RealType> struct blas_backend {
+  typedef RealType value_type;
+  typedef blas_matrix<RealType> matrix_type;
+  typedef std::vector<RealType> vector_type;
+
+  // shape and memory
+
+  static size_t rows(const matrix_type &a) { return a.n_rows; }
+  static size_t cols(const matrix_type &a) { return a.n_cols; }
+  static size_t rows(const vector_type &x) { return x.size(); }
+  static size_t cols(const vector_type &) { return 1; }
+
+  static RealType *data(matrix_type &a) { return a.mem.data(); }
+  static const RealType *data(const matrix_type &a) { return a.mem.data(); }
+  static RealType *data(vector_type &x) { return x.data(); }
+  static const RealType *data(const vector_type &x) { return x.data(); }
+
+  static void resize(matrix_type &a, size_t r, size_t c) {
+    a.n_rows = r;
+    a.n_cols = c;
+    a.mem.resize(r * c);
+  }
+
+  static void resize(vector_type &x, size_t r, size_t = 1) { x.resize(r); }
+
+  static vector_type constant(size_t n, RealType v) {
+    return vector_type(n, v);
+  }
+
+  // predicates
+
+  static bool is_symmetric(const matrix_type &a) {
+    if (a.n_rows != a.n_cols)
+      return false;
+
+    for (size_t j = 0; j < a.n_cols; ++j)
+      for (size_t i = j + 1; i < a.n_rows; ++i)
+        if (a(i, j) != a(j, i))
+          return false;
+
+    return true;
+  }
+
+  static bool approx_equal(const matrix_type &a, const matrix_type &b,
+                           RealType tol) {
+    return a.n_rows == b.n_rows && a.n_cols == b.n_cols &&
+           approx_equal(a.mem, b.mem, tol);
+  }
+
+  static bool approx_equal(const vector_type &a, const vector_type &b,
+                           RealType tol) {
+    if (a.size() != b.size())
+      return false;
+
+    for (size_t i = 0; i < a.size(); ++i)
+      if (std::abs(a[i] - b[i]) > tol)
+        return false;
+
+    return true;
+  }
+
+  // factorizations
+
+  //! Returns the lower Cholesky factor of a, throws std::runtime_error if a
+  //! is not positive definite
+  static matrix_type cholesky(const matrix_type &a) {
+    matrix_type l = a;
+    if (detail::potrf(static_cast<int>(l.n_rows), data(l)) != 0)
+      throw std::runtime_error("chol(): decomposition failed");
+
+    detail::zero_upper(l);
+    return l;
+  }
+
+  //! Returns the inverse of the lower triangular matrix l
+  static matrix_type inverse_lower(const matrix_type &l) {
+    matrix_type inv = l;
+    if (detail::trtri(static_cast<int>(inv.n_rows), data(inv)) != 0)
+      throw std::runtime_error("inv(): matrix is singular");
+
+    detail::zero_upper(inv);
+    return inv;
+  }
+
+  //! Returns a' a
+  static matrix_type crossprod(const matrix_type &a) {
+    return crossprod(a, a);
+  }
+
+  //! Returns a' b
+  static matrix_type crossprod(const matrix_type &a, const matrix_type &b) {
+    matrix_type c(a.n_cols, b.n_cols);
+    detail::gemm_tn(static_cast<int>(a.n_cols), static_cast<int>(b.n_cols),
+                    static_cast<int>(a.n_rows), data(a), data(b), data(c));
+    return c;
+  }
+
+  //! Returns log(det(l l')) of the lower triangular matrix l
+  static RealType log_det_lower(const matrix_type &l) {
+    RealType s = 0;
+    for (size_t i = 0; i < l.n_rows; ++i)
+      s += std::log(l(i, i));
+    return 2 * s;
+  }
+
+  // products
+
+  //! x <- l x, for a lower triangular l, in place
+  static void lower_mult(const matrix_type &l, vector_type &x) {
+    detail::trmv(static_cast<int>(l.n_rows), data(l), data(x));
+  }
+
+  //! x <- l x, for a lower triangular l and every column of x, in place
+  static void lower_mult(const matrix_type &l, matrix_type &x) {
+    detail::trmm(static_cast<int>(l.n_rows), static_cast<int>(x.n_cols),
+                 data(l), data(x));
+  }
+
+  //! y <- y + a x
+  static void mult_add(const matrix_type &a, const vector_type &x,
+                       vector_type &y) {
+    detail::gemv(static_cast<int>(a.n_rows), static_cast<int>(a.n_cols),
+                 data(a), data(x), data(y));
+  }
+
+  //! x <- x + mu
+  static void add_cols(vector_type &x, const vector_type &mu) {
+    for (size_t i = 0; i < x.size(); ++i)
+      x[i] += mu[i];
+  }
+
+  //! x <- x + mu, for every column of x
+  static void add_cols(matrix_type &x, const vector_type &mu) {
+    for (size_t j = 0; j < x.n_cols; ++j)
+      for (size_t i = 0; i < x.n_rows; ++i)
+        x(i, j) += mu[i];
+  }
+};
+
+} // namespace linalg
+
+} // namespace baaraan
+
+#endif // BAARAAN_BLAS_BACKEND_H
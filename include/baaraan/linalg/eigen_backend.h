@@ -0,0 +1,138 @@
+///
+/// @file
+/// This file contains the Eigen linear algebra backend, see
+/// armadillo_backend.h for the interface of a backend.
+///
+/// @code
+/// typedef baaraan::linalg::eigen_backend<double> backend;
+/// baaraan::mvnorm_distribution<double, backend> mvnorm(means, sigma);
+/// Eigen::VectorXd x = mvnorm(gen);
+/// @endcode
+///
+
+#ifndef BAARAAN_EIGEN_BACKEND_H
+#define BAARAAN_EIGEN_BACKEND_H
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <stdexcept>
+
+namespace baaraan {
+
+namespace linalg {
+
+///
+/// @brief      Eigen Linear Algebra Backend
+///
+/// @tparam     RealType  Indicates the type of the matrix elements
+///
+/// @ingroup    LinearAlgebraBackends
+///
+template <class RealType> struct eigen_backend {
+  typedef RealType value_type;
+  typedef Eigen::Matrix<RealType, Eigen::Dynamic, Eigen::Dynamic> matrix_type;
+  typedef Eigen::Matrix<RealType, Eigen::Dynamic, 1> vector_type;
+
+  // shape and memory
+
+  static size_t rows(const matrix_type &a) { return a.rows(); }
+  static size_t cols(const matrix_type &a) { return a.cols(); }
+  static size_t rows(const vector_type &x) { return x.size(); }
+  static size_t cols(const vector_type &) { return 1; }
+
+  static RealType *data(matrix_type &a) { return a.data(); }
+  static const RealType *data(const matrix_type &a) { return a.data(); }
+  static RealType *data(vector_type &x) { return x.data(); }
+  static const RealType *data(const vector_type &x) { return x.data(); }
+
+  static void resize(matrix_type &a, size_t r, size_t c) { a.resize(r, c); }
+  static void resize(vector_type &x, size_t r, size_t = 1) { x.resize(r); }
+
+  static vector_type constant(size_t n, RealType v) {
+    return vector_type::Constant(n, v);
+  }
+
+  // predicates
+
+  static bool is_symmetric(const matrix_type &a) {
+    return a.rows() == a.cols() && a == a.transpose();
+  }
+
+  static bool approx_equal(const matrix_type &a, const matrix_type &b,
+                           RealType tol) {
+    return a.rows() == b.rows() && a.cols() == b.cols() &&
+           (a.size() == 0 || (a - b).cwiseAbs().maxCoeff() <= tol);
+  }
+
+  static bool approx_equal(const vector_type &a, const vector_type &b,
+                           RealType tol) {
+    return a.size() == b.size() &&
+           (a.size() == 0 || (a - b).cwiseAbs().maxCoeff() <= tol);
+  }
+
+  // factorizations
+
+  //! Returns the lower Cholesky factor of a, throws std::runtime_error if a
+  //! is not positive definite
+  static matrix_type cholesky(const matrix_type &a) {
+    Eigen::LLT<matrix_type> llt(a);
+    if (llt.info() != Eigen::Success)
+      throw std::runtime_error("chol(): decomposition failed");
+
+    return llt.matrixL();
+  }
+
+  //! Returns the inverse of the lower triangular matrix l
+  static matrix_type inverse_lower(const matrix_type &l) {
+    return l.template triangularView<Eigen::Lower>().solve(
+        matrix_type::Identity(l.rows(), l.cols()));
+  }
+
+  //! Returns a' a
+  static matrix_type crossprod(const matrix_type &a) {
+    return a.transpose() * a;
+  }
+
+  //! Returns a' b
+  static matrix_type crossprod(const matrix_type &a, const matrix_type &b) {
+    return a.transpose() * b;
+  }
+
+  //! Returns log(det(l l')) of the lower triangular matrix l
+  static RealType log_det_lower(const matrix_type &l) {
+    return 2 * l.diagonal().array().log().sum();
+  }
+
+  // products, x aliases both triangular products below, so Eigen evaluates
+  // them into a temporary before assigning them to x
+
+  //! x <- l x, for a lower triangular l
+  static void lower_mult(const matrix_type &l, vector_type &x) {
+    x = l.template triangularView<Eigen::Lower>() * x;
+  }
+
+  //! x <- l x, for a lower triangular l and every column of x
+  static void lower_mult(const matrix_type &l, matrix_type &x) {
+    x = l.template triangularView<Eigen::Lower>() * x;
+  }
+
+  //! y <- y + a x
+  static void mult_add(const matrix_type &a, const vector_type &x,
+                       vector_type &y) {
+    y.noalias() += a * x;
+  }
+
+  //! x <- x + mu
+  static void add_cols(vector_type &x, const vector_type &mu) { x += mu; }
+
+  //! x <- x + mu, for every column of x
+  static void add_cols(matrix_type &x, const vector_type &mu) {
+    x.colwise() += mu;
+  }
+};
+
+} // namespace linalg
+
+} // namespace baaraan
+
+#endif // BAARAAN_EIGEN_BACKEND_H
@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of circulant_mvnorm_distribution, see compiled.h
+///
+
+#include "baaraan/dists/circulant_mvnorm_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_CIRCULANT_MVNORM_INSTANCES()
+
+} // namespace baaraan
@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of dirichlet_distribution, see compiled.h
+///
+
+#include "baaraan/dists/dirichlet_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_DIRICHLET_INSTANCES()
+
+} // namespace baaraan
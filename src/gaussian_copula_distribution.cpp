@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of gaussian_copula_distribution, see compiled.h
+///
+
+#include "baaraan/dists/gaussian_copula_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_GAUSSIAN_COPULA_INSTANCES()
+
+} // namespace baaraan
@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of gmrf_distribution, see compiled.h
+///
+
+#include "baaraan/dists/gmrf_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_GMRF_INSTANCES()
+
+} // namespace baaraan
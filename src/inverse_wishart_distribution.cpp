@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of inverse_wishart_distribution, see compiled.h
+///
+
+#include "baaraan/dists/inverse_wishart_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_INVERSE_WISHART_INSTANCES()
+
+} // namespace baaraan
@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of matrix_normal_distribution, see compiled.h
+///
+
+#include "baaraan/dists/matrix_normal_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_MATRIX_NORMAL_INSTANCES()
+
+} // namespace baaraan
@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of mixture_mvnorm_distribution, see compiled.h
+///
+
+#include "baaraan/dists/mixture_mvnorm_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_MIXTURE_MVNORM_INSTANCES()
+
+} // namespace baaraan
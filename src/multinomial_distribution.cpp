@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of multinomial_distribution, see compiled.h
+///
+
+#include "baaraan/dists/multinomial_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_MULTINOMIAL_INSTANCES()
+
+} // namespace baaraan
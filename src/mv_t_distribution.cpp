@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of mv_t_distribution, see compiled.h
+///
+
+#include "baaraan/dists/mv_t_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_MV_T_INSTANCES()
+
+} // namespace baaraan
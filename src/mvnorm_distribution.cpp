@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of mvnorm_distribution, see compiled.h
+///
+
+#include "baaraan/dists/mvnorm_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_MVNORM_INSTANCES()
+
+} // namespace baaraan
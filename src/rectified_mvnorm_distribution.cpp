@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of rectified_mvnorm_distribution, see compiled.h
+///
+
+#include "baaraan/dists/rectified_mvnorm_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_RECTIFIED_MVNORM_INSTANCES()
+
+} // namespace baaraan
@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of rectified_normal_distribution, see compiled.h
+///
+
+#include "baaraan/dists/rectified_normal_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_RECTIFIED_NORMAL_INSTANCES()
+
+} // namespace baaraan
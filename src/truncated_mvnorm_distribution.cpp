@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of truncated_mvnorm_distribution, see compiled.h
+///
+
+#include "baaraan/dists/truncated_mvnorm_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_TRUNCATED_MVNORM_INSTANCES()
+
+} // namespace baaraan
@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of truncated_normal_distribution, see compiled.h
+///
+
+#include "baaraan/dists/truncated_normal_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_TRUNCATED_NORMAL_INSTANCES()
+
+} // namespace baaraan
@@ -0,0 +1,12 @@
+///
+/// @file
+/// Explicit instantiations of wishart_distribution, see compiled.h
+///
+
+#include "baaraan/dists/wishart_distribution.h"
+
+namespace baaraan {
+
+BAARAAN_WISHART_INSTANCES()
+
+} // namespace baaraan
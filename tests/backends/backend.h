@@ -0,0 +1,42 @@
+///
+/// @file
+/// Selects the linear algebra backend of the tests in this directory, which
+/// are built once for every backend, see tests/CMakeLists.txt
+///
+
+#ifndef BAARAAN_TESTS_BACKEND_H
+#define BAARAAN_TESTS_BACKEND_H
+
+#include <armadillo>
+#include <cstring>
+
+#if defined(BAARAAN_TEST_EIGEN_BACKEND)
+#include "linalg/eigen_backend.h"
+#elif defined(BAARAAN_TEST_BLAS_BACKEND)
+#include "linalg/blas_backend.h"
+#endif
+
+#include "linalg/armadillo_backend.h"
+
+#if defined(BAARAAN_TEST_EIGEN_BACKEND)
+typedef baaraan::linalg::eigen_backend<double> backend;
+#elif defined(BAARAAN_TEST_BLAS_BACKEND)
+typedef baaraan::linalg::blas_backend<double> backend;
+#else
+typedef baaraan::linalg::armadillo_backend<double> backend;
+#endif
+
+// Copies between Armadillo and the backend, through their column-major memory
+template <class T> T from_arma(const arma::Mat<double> &a) {
+  T x;
+  backend::resize(x, a.n_rows, a.n_cols);
+  std::memcpy(backend::data(x), a.memptr(), a.n_elem * sizeof(double));
+  return x;
+}
+
+template <class T> arma::Mat<double> to_arma(const T &x) {
+  return arma::Mat<double>(backend::data(x), backend::rows(x),
+                           backend::cols(x));
+}
+
+#endif // BAARAAN_TESTS_BACKEND_H
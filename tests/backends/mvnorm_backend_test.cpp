@@ -0,0 +1,116 @@
+#define BOOST_TEST_MODULE MVNORM_BACKEND TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "boost/test/unit_test.hpp"
+
+#include "backend.h"
+#include "dists/mvnorm_distribution.h"
+
+using namespace baaraan;
+
+typedef mvnorm_distribution<double, backend> backend_mvnorm;
+
+namespace {
+
+const arma::Col<double> tmeans{1, -2, 0.5};
+const arma::Mat<double> tsigma{{2, 0.5, 0.3}, {0.5, 1, -0.2}, {0.3, -0.2, 1.5}};
+
+backend_mvnorm make_mvnorm() {
+  return backend_mvnorm{from_arma<backend::vector_type>(tmeans),
+                        from_arma<backend::matrix_type>(tsigma)};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE( mvnorm_backend_moments_test )
+{
+  backend_mvnorm mvnorm = make_mvnorm();
+
+  BOOST_CHECK( approx_equal(to_arma(mvnorm.param().covs_lower()),
+                            arma::Mat<double>(arma::chol(tsigma, "lower")),
+                            "absdiff", 1e-12) );
+
+  std::mt19937 gen(42);
+  const size_t n = 100000;
+  arma::Mat<double> sample = to_arma(mvnorm(gen, n));
+
+  BOOST_CHECK( sample.n_rows == 3 && sample.n_cols == n );
+  BOOST_CHECK( approx_equal(arma::Col<double>(arma::mean(sample, 1)), tmeans,
+                            "absdiff", 0.02) );
+  BOOST_CHECK( approx_equal(arma::cov(sample.t()), tsigma, "absdiff", 0.03) );
+}
+
+BOOST_AUTO_TEST_CASE( mvnorm_backend_matches_armadillo_test )
+{
+  backend_mvnorm mvnorm = make_mvnorm();
+  mvnorm_distribution<double> reference{tmeans, tsigma};
+
+  std::mt19937 gen(42);
+  std::mt19937 gen2 = gen;
+
+  // every backend consumes the normal values in the same order, so the
+  // draws only differ by the rounding of their factorizations
+  for (int k = 0; k < 5; ++k)
+    BOOST_CHECK( approx_equal(to_arma(mvnorm(gen)),
+                              arma::Mat<double>(reference(gen2)), "absdiff",
+                              1e-10) );
+
+  BOOST_CHECK( approx_equal(to_arma(mvnorm(gen, 20)), reference(gen2, 20),
+                            "absdiff", 1e-10) );
+}
+
+BOOST_AUTO_TEST_CASE( mvnorm_backend_condition_test )
+{
+  backend_mvnorm mvnorm = make_mvnorm();
+  mvnorm_distribution<double> reference{tmeans, tsigma};
+
+  const arma::Col<double> values{0.5};
+  auto cond = mvnorm.param().condition({1}).given(
+      from_arma<backend::vector_type>(values));
+  auto ref = reference.param().condition({1}).given(values);
+
+  BOOST_CHECK( cond.dims() == 2 );
+  BOOST_CHECK( approx_equal(to_arma(cond.means()),
+                            arma::Mat<double>(ref.means()), "absdiff",
+                            1e-12) );
+  BOOST_CHECK( approx_equal(to_arma(cond.sigma()), ref.sigma(), "absdiff",
+                            1e-12) );
+}
+
+BOOST_AUTO_TEST_CASE( mvnorm_backend_snapshot_test )
+{
+  backend_mvnorm mvnorm = make_mvnorm();
+
+  std::mt19937 gen(42);
+  mvnorm(gen);
+
+  // the layout of a snapshot does not depend on the backend
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << mvnorm;
+
+  const arma::Mat<double> one(1, 1, arma::fill::eye);
+  mvnorm_distribution<double> restored{arma::Col<double>{0}, one};
+  ss >> restored;
+
+  BOOST_CHECK( ss );
+  BOOST_CHECK( approx_equal(restored.param().covs_lower(),
+                            to_arma(mvnorm.param().covs_lower()), "absdiff",
+                            0) );
+
+  std::stringstream back(std::ios::in | std::ios::out | std::ios::binary);
+  back << restored;
+
+  backend_mvnorm roundtrip = make_mvnorm();
+  back >> roundtrip;
+
+  BOOST_CHECK( back );
+  BOOST_CHECK( roundtrip == mvnorm );
+
+  std::mt19937 gen2 = gen;
+  BOOST_CHECK( approx_equal(to_arma(mvnorm(gen, 5)),
+                            to_arma(roundtrip(gen2, 5)), "absdiff", 0) );
+}
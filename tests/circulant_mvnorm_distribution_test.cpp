@@ -0,0 +1,171 @@
+#define BOOST_TEST_MODULE CIRCULANT_MVNORM_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <sstream>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/circulant_mvnorm_distribution.h"
+
+using namespace baaraan;
+
+typedef circulant_mvnorm_distribution<double>::param_type circulant_param;
+
+namespace {
+
+// Gaussian covariance, exp(-(dx / ell)^2), of a 1-D process
+std::function<double(double)> gaussian_cov(double ell) {
+  return [ell](double dx) { return std::exp(-(dx / ell) * (dx / ell)); };
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE( circulant_mvnorm_moments_test )
+{
+  const size_t n1 = 5, n2 = 4;
+  const double h1 = 1, h2 = 0.5;
+  auto cov = [](double dx, double dy) {
+    return std::exp(-std::sqrt(dx * dx + dy * dy) / 2);
+  };
+
+  // the minimal 8 x 8 embedding of this grid is indefinite
+  circulant_param p{n1, n2, h1, h2, cov, 1.5};
+  BOOST_CHECK( p.m_rows() == 16 && p.m_cols() == 16 );
+
+  // the block Toeplitz covariance of vec(X)
+  arma::Mat<double> tsigma(n1 * n2, n1 * n2);
+  for (size_t a = 0; a < n1 * n2; ++a)
+    for (size_t b = 0; b < n1 * n2; ++b) {
+      const double di = (double(a % n1) - double(b % n1)) * h1;
+      const double dj = (double(a / n1) - double(b / n1)) * h2;
+      tsigma(a, b) = cov(di, dj);
+    }
+
+  circulant_mvnorm_distribution<double> cmvnorm{p};
+
+  std::mt19937 gen(42);
+  const size_t n = 100000;
+  arma::Cube<double> sample = cmvnorm(gen, n);
+  arma::Mat<double> vecs(sample.memptr(), n1 * n2, n);
+
+  BOOST_CHECK( approx_equal(arma::mean(vecs, 1),
+                            arma::Col<double>(n1 * n2).fill(1.5), "absdiff",
+                            0.02) );
+  BOOST_CHECK( approx_equal(arma::cov(vecs.t()), tsigma, "absdiff", 0.03) );
+
+  // the real and the imaginary halves of every FFT are independent fields
+  arma::uvec re = arma::regspace<arma::uvec>(0, 2, n - 2);
+  arma::uvec im = re + 1;
+  arma::Mat<double> cross = arma::cov(vecs.cols(re).t(), vecs.cols(im).t());
+  BOOST_CHECK( arma::abs(cross).max() < 0.03 );
+}
+
+BOOST_AUTO_TEST_CASE( circulant_mvnorm_spare_test )
+{
+  circulant_param p{16, 1.0, gaussian_cov(2)};
+  circulant_mvnorm_distribution<double> batch{p};
+  circulant_mvnorm_distribution<double> single{p};
+
+  std::mt19937 gen(42);
+  std::mt19937 gen2 = gen;
+
+  // single draws return the spare half of the previous FFT every other call,
+  // and are therefore the same as the slices of a batch
+  arma::Cube<double> sample = batch(gen, 5);
+  for (size_t k = 0; k < sample.n_slices; ++k)
+    BOOST_CHECK( approx_equal(sample.slice(k), single(gen2), "absdiff",
+                              1e-12) );
+}
+
+BOOST_AUTO_TEST_CASE( circulant_mvnorm_padding_test )
+{
+  // the minimal embedding of size 16 is indefinite, 32 is not
+  BOOST_CHECK( circulant_param(8, 1.0, gaussian_cov(3)).m_rows() == 32 );
+
+  // three doublings are needed, more than the given max_padding
+  BOOST_CHECK( circulant_param(8, 1.0, gaussian_cov(8)).m_rows() == 128 );
+  BOOST_CHECK_THROW( circulant_param(8, 1.0, gaussian_cov(8), 0, 2),
+                     std::logic_error );
+
+  // an indefinite covariance is never embeddable
+  auto indefinite = [](double dx) {
+    return dx == 0 ? 1.0 : std::abs(dx) == 1 ? -0.9 : 0.0;
+  };
+  BOOST_CHECK_THROW( circulant_param(8, 1.0, indefinite), std::logic_error );
+
+  BOOST_CHECK_THROW( circulant_param(0, 1.0, gaussian_cov(1)),
+                     std::length_error );
+}
+
+BOOST_AUTO_TEST_CASE( circulant_mvnorm_clamp_test )
+{
+  // a rank-one embedding, all but one of its eigenvalues are zero up to
+  // round-off, and are clamped before their square roots are taken
+  circulant_param p{6, 1.0, [](double) { return 1.0; }, 2};
+  BOOST_CHECK( p.sqrt_eigs().is_finite() );
+  BOOST_CHECK( p.sqrt_eigs().min() >= 0 );
+
+  circulant_mvnorm_distribution<double> cmvnorm{p};
+  std::mt19937 gen(42);
+
+  // every draw is a constant field
+  arma::Cube<double> sample = cmvnorm(gen, 4);
+  for (size_t k = 0; k < sample.n_slices; ++k)
+    BOOST_CHECK( sample.slice(k).max() - sample.slice(k).min() < 1e-6 );
+
+  // padded embeddings of nearly singular covariances are clamped too
+  circulant_param q{16, 1.0, gaussian_cov(6)};
+  BOOST_CHECK( q.m_rows() == 64 );
+  BOOST_CHECK( q.sqrt_eigs().is_finite() );
+}
+
+BOOST_AUTO_TEST_CASE( circulant_mvnorm_snapshot_test )
+{
+  circulant_mvnorm_distribution<double> cmvnorm{
+      circulant_param{4, 3, 1.0, 1.0,
+                      [](double dx, double dy) {
+                        return std::exp(-std::abs(dx) - std::abs(dy));
+                      }}};
+
+  // leaves a spare field in the context
+  std::mt19937 gen(42);
+  cmvnorm(gen);
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << cmvnorm;
+
+  circulant_mvnorm_distribution<double> restored{arma::Col<double>{1}};
+  ss >> restored;
+
+  BOOST_CHECK( ss );
+  BOOST_CHECK( restored == cmvnorm );
+
+  std::mt19937 gen2 = gen;
+  for (int k = 0; k < 3; ++k)
+    BOOST_CHECK( approx_equal(cmvnorm(gen), restored(gen2), "absdiff", 0) );
+}
+
+BOOST_AUTO_TEST_CASE( circulant_mvnorm_empty_grid_test )
+{
+  // a snapshot of a grid without any points
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  snapshot::write_header(ss, snapshot::kind::circulant_mvnorm, sizeof(double));
+  snapshot::write_pod(ss, std::uint64_t(0));
+  snapshot::write_pod(ss, std::uint64_t(1));
+  snapshot::write_pod(ss, 0.0);
+  snapshot::write_matrix(ss, arma::Mat<double>(4, 1, arma::fill::ones));
+  snapshot::write_state(ss, std::normal_distribution<double>());
+  snapshot::write_matrix(ss, arma::Mat<double>());
+  snapshot::write_pod(ss, false);
+
+  circulant_mvnorm_distribution<double> restored{
+      arma::Col<double>{1, 0.5}};
+  const circulant_mvnorm_distribution<double> original = restored;
+  ss >> restored;
+
+  BOOST_CHECK( !ss );
+  BOOST_CHECK( restored == original );
+}
@@ -0,0 +1,166 @@
+#define BOOST_TEST_MODULE COMPILED TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "boost/mpl/list.hpp"
+#include "boost/test/unit_test.hpp"
+
+#include "dists/circulant_mvnorm_distribution.h"
+#include "dists/dirichlet_distribution.h"
+#include "dists/gaussian_copula_distribution.h"
+#include "dists/gmrf_distribution.h"
+#include "dists/inverse_wishart_distribution.h"
+#include "dists/matrix_normal_distribution.h"
+#include "dists/mixture_mvnorm_distribution.h"
+#include "dists/multinomial_distribution.h"
+#include "dists/mv_t_distribution.h"
+#include "dists/mvnorm_distribution.h"
+#include "dists/rectified_mvnorm_distribution.h"
+#include "dists/rectified_normal_distribution.h"
+#include "dists/truncated_mvnorm_distribution.h"
+#include "dists/truncated_normal_distribution.h"
+#include "dists/wishart_distribution.h"
+
+#ifndef BAARAAN_USE_COMPILED
+#error "compiled_test must be linked to baaraan::compiled"
+#endif
+
+using namespace baaraan;
+
+// The draws below are all declared extern by BAARAAN_USE_COMPILED, and are
+// therefore resolved from baaraan::compiled, for both real types and engines.
+typedef boost::mpl::list<float, double> real_types;
+typedef boost::mpl::list<int, std::int64_t> int_types;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( compiled_mvnorm_test, T, real_types )
+{
+  arma::Col<T> tmeans{1, -1};
+  arma::Mat<T> tsigma{{2, 0.5}, {0.5, 1}};
+
+  mvnorm_distribution<T> mvnorm{tmeans, tsigma};
+  mv_t_distribution<T> mv_t{5, tmeans, tsigma};
+  rectified_mvnorm_distribution<T> rmvnorm{tmeans, tsigma};
+  truncated_mvnorm_distribution<T> tmvnorm{tmeans, tsigma, {0, -2}, {2, 0}};
+
+  std::mt19937 gen(42);
+  std::mt19937_64 gen64(42);
+
+  const size_t n = 20000;
+  arma::Mat<T> sample = mvnorm(gen, n);
+  BOOST_CHECK( sample.n_rows == 2 && sample.n_cols == n );
+  BOOST_CHECK( approx_equal(arma::Col<T>(arma::mean(sample, 1)), tmeans,
+                            "absdiff", T(0.05)) );
+  BOOST_CHECK( mvnorm(gen64).is_finite() );
+  BOOST_CHECK( mvnorm(gen64, 3).is_finite() );
+
+  BOOST_CHECK( mv_t(gen).is_finite() && mv_t(gen64).is_finite() );
+
+  BOOST_CHECK( rmvnorm(gen).min() >= 0 && rmvnorm(gen64).min() >= 0 );
+  BOOST_CHECK( rmvnorm(gen, 3).min() >= 0 && rmvnorm(gen64, 3).min() >= 0 );
+
+  for (arma::Col<T> x : {tmvnorm(gen), tmvnorm(gen64)})
+    BOOST_CHECK( x[0] >= 0 && x[0] <= 2 && x[1] >= -2 && x[1] <= 0 );
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( compiled_univariate_test, T, real_types )
+{
+  rectified_normal_distribution<T> rnorm{0, 1};
+  truncated_normal_distribution<T> tnorm{0, 1, -1, 2};
+
+  std::mt19937 gen(42);
+  std::mt19937_64 gen64(42);
+
+  BOOST_CHECK( rnorm(gen) >= 0 && rnorm(gen64) >= 0 );
+
+  for (T x : {tnorm(gen), tnorm(gen64)})
+    BOOST_CHECK( x >= -1 && x <= 2 );
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( compiled_matrix_test, T, real_types )
+{
+  arma::Mat<T> tscale{{2, 0.5}, {0.5, 1}};
+
+  wishart_distribution<T> wishart{4, tscale};
+  inverse_wishart_distribution<T> iwishart{4, tscale};
+  matrix_normal_distribution<T> mnorm{arma::Mat<T>(2, 3, arma::fill::zeros),
+                                      tscale,
+                                      arma::Mat<T>(3, 3, arma::fill::eye)};
+
+  std::mt19937 gen(42);
+  std::mt19937_64 gen64(42);
+
+  for (const arma::Mat<T> &x :
+       {wishart(gen), wishart(gen64), iwishart(gen), iwishart(gen64)})
+    BOOST_CHECK( x.n_rows == 2 && x.n_cols == 2 && x.is_symmetric() );
+
+  BOOST_CHECK( wishart(gen, 3).n_slices == 3 );
+  BOOST_CHECK( iwishart(gen64, 3).n_slices == 3 );
+
+  BOOST_CHECK( mnorm(gen).n_cols == 3 && mnorm(gen64).n_cols == 3 );
+  BOOST_CHECK( mnorm(gen, 3).n_slices == 3 && mnorm(gen64, 3).n_slices == 3 );
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( compiled_structured_test, T, real_types )
+{
+  circulant_mvnorm_distribution<T> cmvnorm{arma::Col<T>{1, 0.5, 0.25}};
+
+  arma::SpMat<T> tprecision(3, 3);
+  tprecision.diag().fill(2);
+  tprecision(0, 1) = tprecision(1, 0) = -1;
+  tprecision(1, 2) = tprecision(2, 1) = -1;
+  gmrf_distribution<T> gmrf{arma::Col<T>(3, arma::fill::zeros), tprecision};
+
+  dirichlet_distribution<T> dirichlet{arma::Col<T>{0.5, 1, 2}};
+
+  typedef typename gaussian_copula_distribution<T>::marginal_type marginal;
+  gaussian_copula_distribution<T> copula{
+      arma::Mat<T>{{1, 0.5}, {0.5, 1}},
+      std::vector<marginal>{[](T u) { return u; }, [](T u) { return -u; }}};
+
+  typedef typename mvnorm_distribution<T>::param_type component;
+  arma::Mat<T> tsigma(2, 2, arma::fill::eye);
+  mixture_mvnorm_distribution<T> mixture{
+      arma::Col<T>{1, 3},
+      std::vector<component>{component{arma::Col<T>{-2, 0}, tsigma},
+                             component{arma::Col<T>{2, 4}, tsigma}}};
+
+  std::mt19937 gen(42);
+  std::mt19937_64 gen64(42);
+
+  BOOST_CHECK( cmvnorm(gen).is_finite() && cmvnorm(gen64).is_finite() );
+  BOOST_CHECK( cmvnorm(gen, 3).n_slices == 3 );
+  BOOST_CHECK( cmvnorm(gen64, 3).n_slices == 3 );
+
+  BOOST_CHECK( gmrf(gen).is_finite() && gmrf(gen64).is_finite() );
+  BOOST_CHECK( gmrf(gen, 3).n_cols == 3 && gmrf(gen64, 3).n_cols == 3 );
+
+  for (const arma::Col<T> &x : {dirichlet(gen), dirichlet(gen64)})
+    BOOST_CHECK( std::abs(arma::accu(x) - 1) < T(1e-4) );
+  BOOST_CHECK( dirichlet(gen, 3).n_cols == 3 );
+  BOOST_CHECK( dirichlet(gen64, 3).n_cols == 3 );
+
+  for (const arma::Col<T> &x : {copula(gen), copula(gen64)})
+    BOOST_CHECK( x[0] >= 0 && x[0] <= 1 && x[1] == -x[0] );
+  BOOST_CHECK( copula(gen, 3).n_cols == 3 && copula(gen64, 3).n_cols == 3 );
+
+  BOOST_CHECK( mixture(gen).n_elem == 2 && mixture(gen64).n_elem == 2 );
+  BOOST_CHECK( mixture(gen, 3).n_cols == 3 );
+  BOOST_CHECK( mixture(gen64, 3).n_cols == 3 );
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( compiled_multinomial_test, I, int_types )
+{
+  multinomial_distribution<I> multinomial{10, arma::Col<double>{0.2, 0.3, 0.5}};
+
+  std::mt19937 gen(42);
+  std::mt19937_64 gen64(42);
+
+  BOOST_CHECK( arma::accu(multinomial(gen)) == 10 );
+  BOOST_CHECK( arma::accu(multinomial(gen64)) == 10 );
+  BOOST_CHECK( multinomial(gen, 3).n_cols == 3 );
+  BOOST_CHECK( multinomial(gen64, 3).n_cols == 3 );
+}
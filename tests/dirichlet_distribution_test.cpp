@@ -0,0 +1,79 @@
+#define BOOST_TEST_MODULE DIRICHLET_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <random>
+#include <sstream>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/dirichlet_distribution.h"
+
+using namespace baaraan;
+
+BOOST_AUTO_TEST_CASE( dirichlet_moments_test )
+{
+  // concentrations below 1 take the log-space path
+  for (arma::Col<double> talpha : {arma::Col<double>{2, 3, 5},
+                                   arma::Col<double>{0.1, 0.5, 2, 7}}) {
+    dirichlet_distribution<double> dirichlet{talpha};
+
+    std::mt19937 gen(42);
+    arma::Mat<double> sample = dirichlet(gen, 50000);
+
+    BOOST_CHECK( sample.is_finite() );
+    BOOST_CHECK( sample.min() >= 0 );
+    BOOST_CHECK( approx_equal(arma::sum(sample, 0),
+                              arma::Row<double>(sample.n_cols,
+                                                arma::fill::ones),
+                              "absdiff", 1e-12) );
+
+    const double a0 = arma::accu(talpha);
+    arma::Col<double> tvars = talpha % (a0 - talpha) / (a0 * a0 * (a0 + 1));
+
+    BOOST_CHECK( approx_equal(arma::mean(sample, 1), dirichlet.means(),
+                              "absdiff", 0.005) );
+    BOOST_CHECK( approx_equal(arma::var(sample, 0, 1), tvars, "absdiff",
+                              0.001) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( dirichlet_single_draw_test )
+{
+  // single draws run the batch kernel on one column
+  arma::Col<double> talpha{0.1, 0.5, 2, 7};
+  dirichlet_distribution<double> dirichlet{talpha};
+
+  std::mt19937 gen(42);
+  const size_t n = 50000;
+  arma::Mat<double> sample(talpha.n_elem, n);
+  for (size_t j = 0; j < n; ++j)
+    sample.col(j) = dirichlet(gen);
+
+  BOOST_CHECK( sample.is_finite() );
+  BOOST_CHECK( approx_equal(arma::sum(sample, 0),
+                            arma::Row<double>(n, arma::fill::ones), "absdiff",
+                            1e-12) );
+  BOOST_CHECK( approx_equal(arma::mean(sample, 1), dirichlet.means(),
+                            "absdiff", 0.005) );
+}
+
+BOOST_AUTO_TEST_CASE( dirichlet_snapshot_test )
+{
+  dirichlet_distribution<double> dirichlet{{0.5, 1, 4}};
+
+  std::mt19937 gen(42);
+  dirichlet(gen, 10);
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << dirichlet;
+
+  dirichlet_distribution<double> restored{{1, 1}};
+  ss >> restored;
+
+  BOOST_CHECK( ss );
+  BOOST_CHECK( restored == dirichlet );
+
+  std::mt19937 gen2 = gen;
+  BOOST_CHECK( approx_equal(dirichlet(gen, 10), restored(gen2, 10), "absdiff",
+                            0) );
+}
@@ -0,0 +1,84 @@
+#define BOOST_TEST_MODULE GAUSSIAN_COPULA_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <cmath>
+#include <random>
+
+#include "boost/math/distributions/exponential.hpp"
+#include "boost/math/distributions/lognormal.hpp"
+#include "boost/test/unit_test.hpp"
+
+#include "dists/gaussian_copula_distribution.h"
+
+using namespace baaraan;
+
+typedef gaussian_copula_distribution<double>::marginal_type marginal_type;
+
+BOOST_AUTO_TEST_CASE( gaussian_copula_marginals_test )
+{
+  arma::Mat<double> tcorr{{1, 0.5}, {0.5, 1}};
+  gaussian_copula_distribution<double> copula{
+      tcorr, {boost::math::exponential_distribution<>(2),
+              [](double u) { return u; }}};
+
+  std::mt19937 gen(42);
+  arma::Mat<double> sample = copula(gen, 20000);
+
+  arma::Col<double> tmeans{0.5, 0.5};
+  BOOST_CHECK( approx_equal(arma::mean(sample, 1), tmeans, "absdiff", 0.02) );
+  BOOST_CHECK( sample.row(0).min() >= 0 );
+  BOOST_CHECK( sample.row(1).min() >= 0 && sample.row(1).max() <= 1 );
+
+  // Spearman's correlation of a Gaussian copula, 6 / pi * asin(rho / 2)
+  arma::Mat<double> ranks(2, sample.n_cols);
+  for (size_t i = 0; i < 2; ++i)
+    ranks.row(i) = arma::conv_to<arma::Row<double>>::from(
+        arma::sort_index(arma::sort_index(sample.row(i))));
+
+  double rho_s = arma::as_scalar(arma::cor(ranks.row(0), ranks.row(1)));
+  BOOST_CHECK_CLOSE( rho_s, 6 / M_PI * std::asin(0.25), 5 );
+}
+
+BOOST_AUTO_TEST_CASE( gaussian_copula_tabulated_test )
+{
+  arma::Mat<double> tcorr{{1, 0.3}, {0.3, 1}};
+  boost::math::lognormal_distribution<> lnorm(0, 0.5);
+
+  gaussian_copula_distribution<double> exact{tcorr, {lnorm, lnorm}};
+  gaussian_copula_distribution<double> tabulated{
+      tcorr, {marginal_type(lnorm, 1024), marginal_type(lnorm, 1024)}};
+
+  BOOST_CHECK( tabulated.marginals()[0].tabulated() );
+  BOOST_CHECK( !exact.marginals()[0].tabulated() );
+
+  std::mt19937 gen1(42), gen2(42);
+  arma::Mat<double> x = exact(gen1, 1000);
+  arma::Mat<double> y = tabulated(gen2, 1000);
+
+  BOOST_CHECK( approx_equal(x, y, "reldiff", 1e-3) );
+
+  // single draws follow the same transformation
+  std::mt19937 gen3(42);
+  gaussian_copula_distribution<double>::context_type ctx;
+  BOOST_CHECK( approx_equal(x.col(0), exact(gen3, ctx), "reldiff", 1e-12) );
+}
+
+BOOST_AUTO_TEST_CASE( gaussian_copula_batch_test )
+{
+  arma::Mat<double> tcorr{{1, -0.4, 0.2}, {-0.4, 1, 0.5}, {0.2, 0.5, 1}};
+  boost::math::lognormal_distribution<> lnorm(0, 0.5);
+
+  gaussian_copula_distribution<double> batch{
+      tcorr, {boost::math::exponential_distribution<>(2), lnorm,
+              marginal_type(lnorm, 1024)}};
+  gaussian_copula_distribution<double> single = batch;
+
+  std::mt19937 gen(42);
+  std::mt19937 gen2 = gen;
+
+  // both go through the same normal CDF, exact and tabulated rows alike
+  arma::Mat<double> sample = batch(gen, 50);
+  for (size_t j = 0; j < sample.n_cols; ++j)
+    BOOST_CHECK( approx_equal(sample.col(j), single(gen2), "reldiff",
+                              1e-12) );
+}
@@ -0,0 +1,317 @@
+#define BOOST_TEST_MODULE GMRF_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/gmrf_distribution.h"
+
+using namespace baaraan;
+
+namespace {
+
+// Precision of a stationary AR(1) process, a tridiagonal matrix
+arma::SpMat<double> ar1_precision(size_t d, double phi) {
+  arma::SpMat<double> q(d, d);
+  for (size_t i = 0; i < d; ++i) {
+    q(i, i) = (i == 0 || i == d - 1) ? 1 : 1 + phi * phi;
+    if (i + 1 < d) {
+      q(i, i + 1) = -phi;
+      q(i + 1, i) = -phi;
+    }
+  }
+  return q;
+}
+
+// Laplacian of a rows x cols grid, plus tau on its diagonal
+arma::SpMat<double> grid_precision(size_t rows, size_t cols, double tau) {
+  const size_t d = rows * cols;
+  arma::SpMat<double> q(d, d);
+  for (size_t c = 0; c < cols; ++c)
+    for (size_t r = 0; r < rows; ++r) {
+      const size_t i = r + c * rows;
+      q(i, i) += tau;
+      for (const size_t j : {r + 1 < rows ? i + 1 : i,
+                             c + 1 < cols ? i + rows : i}) {
+        if (j == i)
+          continue;
+        q(i, j) = -1;
+        q(j, i) = -1;
+        q(i, i) += 1;
+        q(j, j) += 1;
+      }
+    }
+  return q;
+}
+
+// Checks the factorization of p against the dense precision matrix tq, with
+// z' inv(Q) z = |inv(L) P z|^2 and inv(Q) z = P' inv(L') inv(L) P z
+void check_factor(const gmrf_distribution<double>::param_type &p,
+                  const arma::Mat<double> &tq) {
+  const size_t d = tq.n_rows;
+
+  std::vector<char> seen(d, 0);
+  for (const size_t v : p.perm())
+    seen[v] = 1;
+  BOOST_CHECK( p.perm().size() == d &&
+               std::find(seen.begin(), seen.end(), 0) == seen.end() );
+
+  BOOST_CHECK( std::abs(p.log_det() - arma::log_det_sympd(tq)) < 1e-8 );
+
+  arma::Mat<double> z(d, 3);
+  for (size_t k = 0; k < z.n_elem; ++k)
+    z[k] = std::sin(1.0 + k);
+
+  const arma::uvec perm = arma::conv_to<arma::uvec>::from(p.perm());
+  arma::Mat<double> y = z.rows(perm).t();
+
+  p.factor().solve_lower(y.memptr(), y.n_rows);
+  BOOST_CHECK( approx_equal(y * y.t(), z.t() * arma::solve(tq, z), "absdiff",
+                            1e-10) );
+
+  p.factor().solve_upper(y.memptr(), y.n_rows);
+  arma::Mat<double> x(d, z.n_cols);
+  x.rows(perm) = y.t();
+  BOOST_CHECK( approx_equal(x, arma::solve(tq, z), "absdiff", 1e-10) );
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE( gmrf_moments_test )
+{
+  arma::Col<double> tmeans {1, -1, 0, 2, 0.5};
+  arma::SpMat<double> tprecision = ar1_precision(5, 0.6);
+  arma::Mat<double> tsigma = arma::inv(arma::Mat<double>(tprecision));
+
+  gmrf_distribution<double> gmrf{tmeans, tprecision};
+
+  BOOST_CHECK( std::abs(gmrf.param().log_det() -
+                        arma::log_det_sympd(arma::Mat<double>(tprecision))) <
+               1e-10 );
+
+  std::mt19937 gen(42);
+  arma::Mat<double> sample = gmrf(gen, 50000);
+
+  BOOST_CHECK( approx_equal(arma::mean(sample, 1), tmeans, "absdiff", 0.05) );
+  BOOST_CHECK( approx_equal(arma::cov(sample.t()), tsigma, "absdiff", 0.05) );
+
+  // batches are the same draws as repeated single draws
+  std::mt19937 gen2 = gen;
+  gmrf_distribution<double> single{tmeans, tprecision};
+  sample = gmrf(gen, 10);
+  for (size_t j = 0; j < sample.n_cols; ++j)
+    BOOST_CHECK( approx_equal(sample.col(j), single(gen2), "absdiff", 1e-10) );
+}
+
+BOOST_AUTO_TEST_CASE( gmrf_log_pdf_test )
+{
+  arma::Col<double> tmeans {1, -1, 0, 2};
+  arma::SpMat<double> tprecision = ar1_precision(4, -0.3);
+  arma::Mat<double> tq(tprecision);
+
+  gmrf_distribution<double> gmrf{tmeans, tprecision};
+
+  std::mt19937 gen(42);
+  arma::Mat<double> x = gmrf(gen, 5);
+  arma::Col<double> lp = gmrf.log_pdf(x);
+
+  for (size_t j = 0; j < x.n_cols; ++j) {
+    arma::Col<double> diff = x.col(j) - tmeans;
+    double tlp =
+        0.5 * (arma::log_det_sympd(tq) - 4 * std::log(2 * arma::datum::pi)) -
+        0.5 * arma::as_scalar(diff.t() * tq * diff);
+    BOOST_CHECK( std::abs(lp[j] - tlp) < 1e-10 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( gmrf_condition_test )
+{
+  arma::Col<double> tmeans {1, 2, 3, 4};
+  arma::SpMat<double> tprecision = ar1_precision(4, 0.5);
+  arma::Mat<double> tsigma = arma::inv(arma::Mat<double>(tprecision));
+
+  gmrf_distribution<double>::param_type p{tmeans, tprecision};
+  arma::Col<double> x {4, 0};
+  auto cond = p.condition({3, 0}, x);
+
+  // sigma_fg inv(sigma_gg) and its Schur complement, computed directly
+  arma::uvec f {1, 2}, g {3, 0};
+  arma::Mat<double> reg = tsigma(f, g) * arma::inv(tsigma(g, g));
+  arma::Mat<double> schur = tsigma(f, f) - reg * tsigma(g, f);
+  arma::Col<double> tmu = tmeans(f) + reg * (x - tmeans(g));
+
+  BOOST_CHECK( cond.dims() == 2 );
+  BOOST_CHECK( approx_equal(cond.means(), tmu, "absdiff", 1e-10) );
+  BOOST_CHECK( approx_equal(arma::inv(arma::Mat<double>(cond.precision())),
+                            schur, "absdiff", 1e-10) );
+
+  BOOST_CHECK_THROW( p.condition({0, 0}, {1, 1}), std::logic_error );
+  BOOST_CHECK_THROW( p.condition({0}, {1, 1}), std::length_error );
+}
+
+BOOST_AUTO_TEST_CASE( gmrf_snapshot_test )
+{
+  gmrf_distribution<double> gmrf{{0, 1, 2}, ar1_precision(3, 0.4)};
+
+  std::mt19937 gen(42);
+  gmrf(gen, 10);
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << gmrf;
+
+  gmrf_distribution<double> restored{{0}, ar1_precision(1, 0)};
+  ss >> restored;
+
+  BOOST_CHECK( ss );
+  BOOST_CHECK( restored == gmrf );
+
+  std::mt19937 gen2 = gen;
+  BOOST_CHECK( approx_equal(gmrf(gen, 10), restored(gen2, 10), "absdiff",
+                            0) );
+}
+
+BOOST_AUTO_TEST_CASE( gmrf_grid_test )
+{
+  // 30 x 30 nodes, dissected well past a single leaf
+  arma::SpMat<double> tprecision = grid_precision(30, 30, 0.5);
+  gmrf_distribution<double>::param_type p{
+      arma::Col<double>(900, arma::fill::zeros), tprecision};
+
+  check_factor(p, arma::Mat<double>(tprecision));
+
+  // a profile reducing ordering, e.g., reverse Cuthill-McKee, leaves about
+  // 19000 non-zeros in L
+  BOOST_CHECK( p.factor_nnz() < 14000 );
+
+  // the moments of a smaller grid
+  arma::Col<double> tmeans = arma::linspace<arma::Col<double>>(-1, 1, 72);
+  tprecision = grid_precision(9, 8, 1);
+  gmrf_distribution<double> gmrf{tmeans, tprecision};
+
+  std::mt19937 gen(42);
+  arma::Mat<double> sample = gmrf(gen, 50000);
+
+  BOOST_CHECK( approx_equal(arma::mean(sample, 1), tmeans, "absdiff", 0.02) );
+  BOOST_CHECK( approx_equal(arma::cov(sample.t()),
+                            arma::inv_sympd(arma::Mat<double>(tprecision)),
+                            "absdiff", 0.03) );
+}
+
+BOOST_AUTO_TEST_CASE( gmrf_not_positive_definite_test )
+{
+  // the smallest eigenvalue of a grid Laplacian is 0
+  BOOST_CHECK_THROW( gmrf_distribution<double>(
+                         arma::Col<double>(20, arma::fill::zeros),
+                         grid_precision(5, 4, -0.5)),
+                     std::runtime_error );
+
+  arma::SpMat<double> tprecision(2, 2);
+  tprecision(0, 0) = tprecision(1, 1) = 1;
+  tprecision(0, 1) = tprecision(1, 0) = 2;
+  BOOST_CHECK_THROW( gmrf_distribution<double>::param_type(
+                         arma::Col<double>{0, 0}, tprecision),
+                     std::runtime_error );
+
+  tprecision(0, 1) = 0.5;
+  BOOST_CHECK_THROW( gmrf_distribution<double>::param_type(
+                         arma::Col<double>{0, 0}, tprecision),
+                     std::logic_error );
+}
+
+BOOST_AUTO_TEST_CASE( gmrf_disconnected_test )
+{
+  // two AR(1) blocks and an isolated node, whose orderings are independent
+  arma::SpMat<double> tprecision(36, 36);
+  tprecision.submat(0, 0, 19, 19) = ar1_precision(20, 0.5);
+  tprecision.submat(20, 20, 34, 34) = ar1_precision(15, -0.4);
+  tprecision(35, 35) = 4;
+  arma::Mat<double> tq(tprecision);
+
+  gmrf_distribution<double> gmrf{arma::Col<double>(36, arma::fill::ones),
+                                 tprecision};
+  check_factor(gmrf.param(), tq);
+
+  // L has no non-zeros between the components
+  BOOST_CHECK( gmrf.param().factor_nnz() ==
+               gmrf_distribution<double>::param_type(
+                   arma::Col<double>(20, arma::fill::zeros),
+                   ar1_precision(20, 0.5))
+                       .factor_nnz() +
+                   gmrf_distribution<double>::param_type(
+                       arma::Col<double>(15, arma::fill::zeros),
+                       ar1_precision(15, -0.4))
+                       .factor_nnz() +
+                   1 );
+
+  std::mt19937 gen(42);
+  arma::Mat<double> sample = gmrf(gen, 50000);
+
+  BOOST_CHECK( approx_equal(arma::cov(sample.t()), arma::inv_sympd(tq),
+                            "absdiff", 0.05) );
+}
+
+BOOST_AUTO_TEST_CASE( gmrf_canonical_test )
+{
+  arma::SpMat<double> tprecision = grid_precision(4, 3, 0.5);
+  arma::Col<double> b = arma::linspace<arma::Col<double>>(-2, 3, 12);
+
+  // N_C(b, Q) is N(inv(Q) b, inv(Q))
+  auto p = gmrf_distribution<double>::param_type::canonical(tprecision, b);
+  arma::Col<double> tmeans = arma::solve(arma::Mat<double>(tprecision), b);
+
+  BOOST_CHECK( approx_equal(p.means(), tmeans, "absdiff", 1e-10) );
+  BOOST_CHECK( p == gmrf_distribution<double>::param_type(tmeans, tprecision) );
+  check_factor(p, arma::Mat<double>(tprecision));
+
+  BOOST_CHECK_THROW( gmrf_distribution<double>::param_type::canonical(
+                         tprecision, arma::Col<double>(5, arma::fill::ones)),
+                     std::length_error );
+}
+
+BOOST_AUTO_TEST_CASE( gmrf_invalid_factor_test )
+{
+  const size_t d = 5;
+  gmrf_distribution<double> gmrf{arma::Col<double>(d, arma::fill::zeros),
+                                 ar1_precision(d, 0.4)};
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << gmrf;
+  const std::string valid = ss.str();
+
+  // offsets of the factor in the snapshot, after the header, the means and
+  // the (row, column, value) triplets of the precision matrix
+  const size_t perm =
+      16 + (16 + 8 * d) + (24 + 24 * gmrf.param().precision().n_nonzero);
+  const size_t lp = perm + 8 + 8 * d;
+  const size_t li = lp + 8 + 8 * (d + 1);
+  const size_t lx = li + 8 + 8 * gmrf.param().factor_nnz();
+
+  auto corrupt = [&](size_t offset, auto value) {
+    std::string bytes = valid;
+    std::memcpy(&bytes[offset + 8], &value, sizeof(value));
+
+    std::stringstream is(bytes,
+                         std::ios::in | std::ios::out | std::ios::binary);
+    gmrf_distribution<double> restored{{0}, ar1_precision(1, 0)};
+    const gmrf_distribution<double> original = restored;
+    is >> restored;
+
+    return !is && restored == original;
+  };
+
+  std::uint64_t first_perm;
+  std::memcpy(&first_perm, &valid[perm + 8], 8);
+
+  BOOST_CHECK( corrupt(perm + 8, first_perm) );  // perm[1] == perm[0]
+  BOOST_CHECK( corrupt(lp, std::uint64_t(1)) );  // lp[0] != 0
+  BOOST_CHECK( corrupt(li, std::uint64_t(1)) );  // diagonal not first
+  BOOST_CHECK( corrupt(lx, -1.0) );
+  BOOST_CHECK( corrupt(lx, std::nan("")) );
+}
@@ -0,0 +1,78 @@
+#define BOOST_TEST_MODULE MATRIX_NORMAL_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <random>
+#include <sstream>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/matrix_normal_distribution.h"
+
+using namespace baaraan;
+
+BOOST_AUTO_TEST_CASE( matrix_normal_kronecker_test )
+{
+  arma::Mat<double> tmeans{{1, 2, 3}, {-1, 0, 1}};
+  arma::Mat<double> trow_sigma{{2, 0.5}, {0.5, 1}};
+  arma::Mat<double> tcol_sigma{{1, 0.3, 0.1}, {0.3, 2, -0.4}, {0.1, -0.4, 1.5}};
+
+  matrix_normal_distribution<double> mnorm{tmeans, trow_sigma, tcol_sigma};
+
+  std::mt19937 gen(42);
+  const size_t n = 100000;
+  arma::Cube<double> sample = mnorm(gen, n);
+
+  BOOST_CHECK( sample.n_rows == 2 && sample.n_cols == 3 && sample.n_slices == n );
+
+  // vec(X) of every draw, as the columns of a 6 x n matrix
+  arma::Mat<double> vecs(sample.memptr(), 6, n);
+
+  BOOST_CHECK( approx_equal(arma::mean(vecs, 1), arma::vectorise(tmeans),
+                            "absdiff", 0.02) );
+  BOOST_CHECK( approx_equal(arma::cov(vecs.t()),
+                            arma::kron(tcol_sigma, trow_sigma), "absdiff",
+                            0.05) );
+}
+
+BOOST_AUTO_TEST_CASE( matrix_normal_batch_test )
+{
+  arma::Mat<double> tmeans{{1, 2}, {3, 4}, {5, 6}};
+  arma::Mat<double> trow_sigma{{1, 0.2, 0}, {0.2, 2, 0.3}, {0, 0.3, 1}};
+  arma::Mat<double> tcol_sigma{{1, -0.5}, {-0.5, 3}};
+
+  matrix_normal_distribution<double> batch{tmeans, trow_sigma, tcol_sigma};
+  matrix_normal_distribution<double> single{tmeans, trow_sigma, tcol_sigma};
+
+  std::mt19937 gen(42);
+  std::mt19937 gen2 = gen;
+
+  // batches are the same draws as repeated single draws
+  arma::Cube<double> sample = batch(gen, 10);
+  for (size_t k = 0; k < sample.n_slices; ++k)
+    BOOST_CHECK( approx_equal(sample.slice(k), single(gen2), "absdiff",
+                              1e-10) );
+}
+
+BOOST_AUTO_TEST_CASE( matrix_normal_snapshot_test )
+{
+  // a 1 x 1 matrix, {{1}} is ambiguous with the vector constructor
+  const arma::Mat<double> one(1, 1, arma::fill::ones);
+  matrix_normal_distribution<double> mnorm{arma::Mat<double>{{1, 2}}, 2 * one,
+                                           {{1, 0.5}, {0.5, 1}}};
+
+  std::mt19937 gen(42);
+  mnorm(gen, 3);
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << mnorm;
+
+  matrix_normal_distribution<double> restored{one, one, one};
+  ss >> restored;
+
+  BOOST_CHECK( ss );
+  BOOST_CHECK( restored == mnorm );
+
+  std::mt19937 gen2 = gen;
+  BOOST_CHECK( approx_equal(mnorm(gen, 10), restored(gen2, 10), "absdiff",
+                            0) );
+}
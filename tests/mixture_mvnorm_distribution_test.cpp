@@ -0,0 +1,73 @@
+#define BOOST_TEST_MODULE MIXTURE_MVNORM_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <random>
+#include <vector>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/mixture_mvnorm_distribution.h"
+
+using namespace baaraan;
+
+typedef mvnorm_distribution<double>::param_type component_type;
+
+BOOST_AUTO_TEST_CASE( mixture_mvnorm_means_test )
+{
+  arma::Mat<double> tsigma{{1, 0}, {0, 1}};
+  std::vector<component_type> comps{component_type{{-2, 0}, tsigma},
+                                    component_type{{2, 4}, tsigma}};
+  arma::Col<double> tweights{1, 3};
+
+  mixture_mvnorm_distribution<double> mixture{tweights, comps};
+
+  std::mt19937 gen(42);
+
+  arma::Mat<double> sample(2, 20000);
+  sample.each_col([&](arma::Col<double> &v){v = mixture(gen);});
+
+  arma::Col<double> tmeans{0.25 * -2 + 0.75 * 2, 0.75 * 4};
+  arma::Col<double> means = arma::mean(sample, 1);
+
+  BOOST_CHECK( approx_equal(tmeans, means, "absdiff", 0.05) );
+}
+
+BOOST_AUTO_TEST_CASE( mixture_mvnorm_batch_test )
+{
+  arma::Mat<double> tsigma{{1, 0}, {0, 1}};
+  std::vector<component_type> comps{component_type{{-2, 0}, tsigma},
+                                    component_type{{2, 4}, tsigma},
+                                    component_type{{0, 0}, tsigma}};
+  arma::Col<double> tweights{1, 3, 0};
+
+  mixture_mvnorm_distribution<double> mixture{tweights, comps};
+
+  std::mt19937 gen(42);
+
+  arma::Mat<double> sample = mixture(gen, 20000);
+
+  arma::Col<double> tmeans{0.25 * -2 + 0.75 * 2, 0.75 * 4};
+  arma::Col<double> means = arma::mean(sample, 1);
+
+  BOOST_CHECK( sample.n_cols == 20000 );
+  BOOST_CHECK( approx_equal(tmeans, means, "absdiff", 0.05) );
+}
+
+BOOST_AUTO_TEST_CASE( mixture_mvnorm_log_pdf_test )
+{
+  arma::Mat<double> tsigma{{1, 0}, {0, 1}};
+  std::vector<component_type> comps{component_type{{0, 0}, tsigma},
+                                    component_type{{0, 0}, tsigma}};
+
+  mixture_mvnorm_distribution<double> mixture{{1, 1}, comps};
+
+  arma::Mat<double> x{{0, 1}, {0, 0}};
+  arma::Col<double> lp = mixture.log_pdf(x);
+
+  // Both components are identical, so the mixture is a standard bivariate
+  // normal distribution
+  arma::Col<double> tlp{-std::log(2 * arma::datum::pi),
+                        -std::log(2 * arma::datum::pi) - 0.5};
+
+  BOOST_CHECK( approx_equal(tlp, lp, "absdiff", 1e-10) );
+}
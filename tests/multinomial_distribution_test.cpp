@@ -0,0 +1,41 @@
+#define BOOST_TEST_MODULE MULTINOMIAL_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <random>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/multinomial_distribution.h"
+
+using namespace baaraan;
+
+BOOST_AUTO_TEST_CASE( multinomial_means_test )
+{
+  arma::Col<double> tprobs{0.05, 0.4, 0, 0.25, 0.3};
+
+  // fewer trials than categories use the alias sampler, and more use the
+  // conditional binomials
+  for (int trials : {3, 1000}) {
+    multinomial_distribution<int> multinomial{trials, 2 * tprobs};
+    BOOST_CHECK( multinomial.param().use_alias() == (trials < 5) );
+
+    std::mt19937 gen(42);
+    arma::Mat<int> sample = multinomial(gen, 50000);
+
+    BOOST_CHECK( sample.min() >= 0 );
+    BOOST_CHECK( arma::all(arma::sum(sample, 0) == trials) );
+    BOOST_CHECK( arma::all(sample.row(2) == 0) );
+
+    arma::Col<double> means =
+        arma::mean(arma::conv_to<arma::Mat<double>>::from(sample), 1);
+    BOOST_CHECK( approx_equal(means / trials, tprobs, "absdiff", 0.005) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( multinomial_invalid_param_test )
+{
+  BOOST_CHECK_THROW( multinomial_distribution<int>(-1, {0.5, 0.5}),
+                     std::logic_error );
+  BOOST_CHECK_THROW( multinomial_distribution<int>(10, {0, 0}),
+                     std::logic_error );
+}
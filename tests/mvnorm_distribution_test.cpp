@@ -7,6 +7,8 @@
 
 #include <random>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "boost/test/unit_test.hpp"
 #include "boost/histogram/histogram.hpp"
@@ -49,4 +51,95 @@ BOOST_AUTO_TEST_CASE( mvnorm_stddevs_test )
   arma::Col<double> stddevs = arma::stddev(sample, 1, 1);
 
   BOOST_CHECK( approx_equal(stddevs, tsigma.diag(), "absdiff", 0.01) );
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE( mvnorm_lazy_factorization_test )
+{
+  arma::Col<double> tmeans {1, 1, 1};
+  arma::Mat<double> tsigma{{2, 0.5, 0}, {0.5, 1, 0.2}, {0, 0.2, 3}};
+  mvnorm_distribution<double>::param_type p{tmeans, tsigma};
+
+  // copies share the factorization, whichever computes it first
+  mvnorm_distribution<double>::param_type q = p;
+
+  arma::Mat<double> eye(3, 3, arma::fill::eye);
+
+  BOOST_CHECK( approx_equal(q.inv_covs() * tsigma, eye, "absdiff", 1e-10) );
+  BOOST_CHECK( approx_equal(p.covs_lower() * p.covs_lower().t(), tsigma,
+                            "absdiff", 1e-10) );
+  BOOST_CHECK( std::abs(p.log_det() - std::log(arma::det(tsigma))) < 1e-10 );
+  BOOST_CHECK( p == q );
+}
+
+BOOST_AUTO_TEST_CASE( mvnorm_batch_test )
+{
+  arma::Col<double> tmeans {1, -1, 0};
+  arma::Mat<double> tsigma{{2, 0.5, 0}, {0.5, 1, 0.2}, {0, 0.2, 3}};
+  mvnorm_distribution<double> batch{tmeans, tsigma}, single{tmeans, tsigma};
+
+  std::mt19937 gen1(42), gen2(42);
+
+  // a batch consumes the generator exactly like consecutive single draws
+  arma::Mat<double> sample = batch(gen1, 10);
+
+  for (size_t j = 0; j < sample.n_cols; ++j)
+    BOOST_CHECK( approx_equal(sample.col(j), single(gen2), "absdiff", 1e-10) );
+}
+
+BOOST_AUTO_TEST_CASE( mvnorm_condition_test )
+{
+  arma::Col<double> tmeans {1, 2, 3};
+  arma::Mat<double> tsigma{{2, 0.5, 0.3}, {0.5, 1, 0.2}, {0.3, 0.2, 3}};
+  mvnorm_distribution<double>::param_type p{tmeans, tsigma};
+
+  auto cond = p.condition({2, 0});
+  arma::Col<double> x {4, 0};
+
+  // sigma_fg inv(sigma_gg) and its Schur complement, computed directly
+  arma::uvec f {1}, g {2, 0};
+  arma::Mat<double> reg = tsigma(f, g) * arma::inv(tsigma(g, g));
+  arma::Mat<double> schur = tsigma(f, f) - reg * tsigma(g, f);
+  arma::Col<double> tmu = tmeans(f) + reg * (x - tmeans(g));
+
+  BOOST_CHECK( cond.free_indices() == std::vector<size_t>{1} );
+  BOOST_CHECK( approx_equal(cond.regression(), reg, "absdiff", 1e-10) );
+  BOOST_CHECK( approx_equal(cond.sigma(), schur, "absdiff", 1e-10) );
+
+  mvnorm_distribution<double> mvnorm{cond.given(x)};
+  std::mt19937 gen(42);
+
+  arma::Mat<double> sample = mvnorm(gen, 10000);
+
+  BOOST_CHECK( approx_equal(arma::mean(sample, 1), tmu, "absdiff", 0.05) );
+  BOOST_CHECK_THROW( p.condition({0, 0}), std::logic_error );
+}
+
+BOOST_AUTO_TEST_CASE( mvnorm_shared_context_test )
+{
+  arma::Col<double> tmeans {1, -1, 0};
+  arma::Mat<double> tsigma{{2, 0.5, 0}, {0.5, 1, 0.2}, {0, 0.2, 3}};
+  const mvnorm_distribution<double> shared{tmeans, tsigma};
+
+  // every worker owns its engine and context, and shares the distribution
+  std::vector<arma::Mat<double>> samples(4);
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < samples.size(); ++t)
+    workers.emplace_back([&, t]() {
+      std::mt19937 gen(t);
+      mvnorm_distribution<double>::context_type ctx;
+      samples[t] = shared(gen, ctx, 10000);
+    });
+
+  for (auto &w : workers)
+    w.join();
+
+  for (size_t t = 0; t < samples.size(); ++t) {
+    BOOST_CHECK( approx_equal(arma::mean(samples[t], 1), tmeans, "absdiff",
+                              0.1) );
+
+    // identical to a private, non-shared distribution with the same seed
+    mvnorm_distribution<double> local{tmeans, tsigma};
+    std::mt19937 gen(t);
+    BOOST_CHECK( approx_equal(samples[t], local(gen, 10000), "absdiff", 0) );
+  }
+}
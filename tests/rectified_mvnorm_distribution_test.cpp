@@ -0,0 +1,83 @@
+#define BOOST_TEST_MODULE RECTIFIED_MVNORM_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <cmath>
+#include <random>
+#include <sstream>
+
+#include "boost/test/unit_test.hpp"
+#include "boost/math/distributions/normal.hpp"
+
+#include "dists/rectified_mvnorm_distribution.h"
+
+using namespace baaraan;
+
+BOOST_AUTO_TEST_CASE( rectified_mvnorm_moments_test )
+{
+  arma::Col<double> tmeans {-1, 0, 1.5};
+  arma::Mat<double> tsigma{{4, 1, 0.5}, {1, 1, -0.3}, {0.5, -0.3, 2}};
+  rectified_mvnorm_distribution<double> rmvnorm{tmeans, tsigma};
+
+  std::mt19937 gen(42);
+  arma::Mat<double> sample = rmvnorm(gen, 100000);
+
+  BOOST_CHECK( sample.min() == 0 );
+
+  // every coordinate is a rectified normal, with a point mass at zero
+  boost::math::normal std_normal;
+  for (size_t i = 0; i < tmeans.n_elem; ++i) {
+    const double mean = tmeans[i], stddev = std::sqrt(tsigma(i, i));
+    const double a = mean / stddev;
+    const double cdf = boost::math::cdf(std_normal, a);
+    const double pdf = boost::math::pdf(std_normal, a);
+
+    const double tm = mean * cdf + stddev * pdf;
+    const double tv =
+        (mean * mean + stddev * stddev) * cdf + mean * stddev * pdf - tm * tm;
+
+    arma::Row<double> x = sample.row(i);
+    const double zeros = arma::accu(x == 0);
+
+    BOOST_CHECK( std::abs(zeros / x.n_elem - (1 - cdf)) < 0.005 );
+    BOOST_CHECK( std::abs(arma::mean(x) - tm) < 0.02 );
+    BOOST_CHECK( std::abs(arma::var(x) - tv) < 0.05 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( rectified_mvnorm_batch_test )
+{
+  arma::Col<double> tmeans {0.5, -0.5};
+  arma::Mat<double> tsigma{{1, 0.4}, {0.4, 2}};
+  rectified_mvnorm_distribution<double> batch{tmeans, tsigma};
+  rectified_mvnorm_distribution<double> single{tmeans, tsigma};
+
+  std::mt19937 gen(42);
+  std::mt19937 gen2 = gen;
+
+  // batches are the same draws as repeated single draws
+  arma::Mat<double> sample = batch(gen, 10);
+  for (size_t j = 0; j < sample.n_cols; ++j)
+    BOOST_CHECK( approx_equal(sample.col(j), single(gen2), "absdiff", 1e-10) );
+}
+
+BOOST_AUTO_TEST_CASE( rectified_mvnorm_snapshot_test )
+{
+  rectified_mvnorm_distribution<double> rmvnorm{{1, -1}, {{2, 0.5}, {0.5, 1}}};
+
+  std::mt19937 gen(42);
+  rmvnorm(gen, 3);
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << rmvnorm;
+
+  rectified_mvnorm_distribution<double> restored{
+      {0}, arma::Mat<double>(1, 1, arma::fill::eye)};
+  ss >> restored;
+
+  BOOST_CHECK( ss );
+  BOOST_CHECK( restored == rmvnorm );
+
+  std::mt19937 gen2 = gen;
+  BOOST_CHECK( approx_equal(rmvnorm(gen, 10), restored(gen2, 10), "absdiff",
+                            0) );
+}
@@ -0,0 +1,74 @@
+#define BOOST_TEST_MODULE RECTIFIED_NORMAL_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/rectified_normal_distribution.h"
+
+using namespace baaraan;
+
+namespace {
+
+// Mean and variance of max(0, X), where X ~ N(mean, stddev)
+void rectified_moments(double mean, double stddev, double &m, double &v) {
+  boost::math::normal std_normal;
+  const double a = mean / stddev;
+  const double cdf = boost::math::cdf(std_normal, a);
+  const double pdf = boost::math::pdf(std_normal, a);
+
+  m = mean * cdf + stddev * pdf;
+  v = (mean * mean + stddev * stddev) * cdf + mean * stddev * pdf - m * m;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE( rectified_normal_moments_test )
+{
+  for (double tmean : {-1.0, 0.0, 1.5}) {
+    const double tstddev = 2;
+    rectified_normal_distribution<double> rnorm{tmean, tstddev};
+
+    std::mt19937 gen(42);
+    std::vector<double> sample = rnorm(gen, 100000);
+
+    BOOST_CHECK( *std::min_element(sample.begin(), sample.end()) == 0 );
+
+    // the point mass at the bound, P(X <= 0)
+    const double zeros = std::count(sample.begin(), sample.end(), 0.0);
+    const double tzeros =
+        boost::math::cdf(boost::math::normal(tmean, tstddev), 0.0);
+    BOOST_CHECK( std::abs(zeros / sample.size() - tzeros) < 0.005 );
+
+    double tm, tv;
+    rectified_moments(tmean, tstddev, tm, tv);
+
+    const double m =
+        std::accumulate(sample.begin(), sample.end(), 0.0) / sample.size();
+    double v = 0;
+    for (double x : sample)
+      v += (x - m) * (x - m);
+    v /= sample.size() - 1;
+
+    BOOST_CHECK( std::abs(m - tm) < 0.02 );
+    BOOST_CHECK( std::abs(v - tv) < 0.05 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( rectified_normal_batch_test )
+{
+  rectified_normal_distribution<double> batch{0.5, 1};
+  rectified_normal_distribution<double> single{0.5, 1};
+
+  std::mt19937 gen(42);
+  std::mt19937 gen2 = gen;
+
+  // batches are the same draws as repeated single draws
+  std::vector<double> sample = batch(gen, 11);
+  for (double x : sample)
+    BOOST_CHECK( x == single(gen2) );
+}
@@ -0,0 +1,220 @@
+#define BOOST_TEST_MODULE SNAPSHOT TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <utility>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/inverse_wishart_distribution.h"
+#include "dists/mv_t_distribution.h"
+#include "dists/mvnorm_distribution.h"
+#include "dists/truncated_mvnorm_distribution.h"
+#include "dists/truncated_normal_distribution.h"
+#include "dists/wishart_distribution.h"
+
+using namespace baaraan;
+
+BOOST_AUTO_TEST_CASE( mvnorm_snapshot_test )
+{
+  arma::Col<double> tmeans {1, 2, 3};
+  arma::Mat<double> tsigma{{2, 0.5, 0}, {0.5, 1, 0.2}, {0, 0.2, 3}};
+  mvnorm_distribution<double> mvnorm{tmeans, tsigma};
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << mvnorm;
+
+  const arma::Mat<double> one(1, 1, arma::fill::eye);
+  mvnorm_distribution<double> restored{arma::Col<double>{0}, one};
+  ss >> restored;
+
+  BOOST_CHECK( ss );
+  BOOST_CHECK( restored == mvnorm );
+  BOOST_CHECK( approx_equal(restored.param().covs_lower(),
+                            mvnorm.param().covs_lower(), "absdiff", 0) );
+
+  std::mt19937 gen1(42), gen2(42);
+  BOOST_CHECK( approx_equal(mvnorm(gen1), restored(gen2), "absdiff", 0) );
+}
+
+BOOST_AUTO_TEST_CASE( truncated_mvnorm_snapshot_resumes_chain_test )
+{
+  arma::Col<double> tmeans {0, 0};
+  arma::Mat<double> tsigma{{1, 0.5}, {0.5, 1}};
+  truncated_mvnorm_distribution<double> tmvnorm{tmeans, tsigma, {-1, -1},
+                                                {1, 2}};
+
+  std::mt19937 gen(42);
+  for (int i = 0; i < 10; ++i)
+    tmvnorm(gen);
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << tmvnorm;
+
+  const arma::Mat<double> one(1, 1, arma::fill::eye);
+  truncated_mvnorm_distribution<double> restored{
+      arma::Col<double>{0}, one, arma::Col<double>{-1}, arma::Col<double>{1}};
+  ss >> restored;
+  BOOST_CHECK( ss );
+
+  std::mt19937 gen2 = gen;
+  for (int i = 0; i < 10; ++i)
+    BOOST_CHECK( approx_equal(tmvnorm(gen), restored(gen2), "absdiff", 0) );
+}
+
+BOOST_AUTO_TEST_CASE( wishart_snapshot_test )
+{
+  arma::Mat<double> tscale{{1, 0.5, 0}, {0.5, 2, 0.3}, {0, 0.3, 1}};
+  wishart_distribution<double> wishart{4.5, tscale};
+  inverse_wishart_distribution<double> iwishart{6, tscale};
+
+  std::mt19937 gen(42);
+  wishart(gen);
+  iwishart(gen);
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << wishart << iwishart;
+
+  const arma::Mat<double> one(1, 1, arma::fill::eye);
+  wishart_distribution<double> restored{1, one};
+  inverse_wishart_distribution<double> irestored{1, one};
+  ss >> restored >> irestored;
+
+  BOOST_CHECK( ss );
+  BOOST_CHECK( restored == wishart );
+  BOOST_CHECK( irestored == iwishart );
+
+  std::mt19937 gen2 = gen;
+  BOOST_CHECK( approx_equal(wishart(gen), restored(gen2), "absdiff", 0) );
+  BOOST_CHECK( approx_equal(iwishart(gen), irestored(gen2), "absdiff", 0) );
+}
+
+BOOST_AUTO_TEST_CASE( wishart_snapshot_invalid_test )
+{
+  arma::Mat<double> tscale{{1, 0.5}, {0.5, 2}};
+  arma::Mat<double> tlower = arma::chol(tscale, "lower");
+
+  arma::Mat<double> negative = tlower, upper = tlower, nan = tlower;
+  negative(1, 1) = -negative(1, 1);
+  upper(0, 1) = 0.5;
+  nan(1, 0) = std::numeric_limits<double>::quiet_NaN();
+
+  // a valid factor with too few degrees of freedom, and invalid factors
+  const std::pair<double, arma::Mat<double>> cases[] = {
+      {1, tlower}, {3, negative}, {3, upper}, {3, nan}};
+
+  for (const auto &c : cases) {
+    std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+    snapshot::write_header(ss, snapshot::kind::wishart, sizeof(double));
+    snapshot::write_pod(ss, c.first);
+    snapshot::write_matrix(ss, tscale);
+    snapshot::write_matrix(ss, c.second);
+    snapshot::write_state(ss, std::normal_distribution<double>());
+    snapshot::write_state(ss, std::chi_squared_distribution<double>());
+
+    wishart_distribution<double> restored{3, tscale};
+    ss >> restored;
+
+    BOOST_CHECK( !ss );
+    BOOST_CHECK( restored.dof() == 3 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( mvnorm_snapshot_invalid_factor_test )
+{
+  arma::Col<double> tmeans{1, 2};
+  arma::Mat<double> tsigma{{1, 0.5}, {0.5, 2}};
+  arma::Mat<double> tlower = arma::chol(tsigma, "lower");
+
+  arma::Mat<double> negative = tlower, upper = tlower, inf = tlower;
+  negative(0, 0) = -negative(0, 0);
+  upper(0, 1) = 0.5;
+  inf(1, 1) = std::numeric_limits<double>::infinity();
+
+  for (const arma::Mat<double> &lower : {negative, upper, inf}) {
+    std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+    snapshot::write_header(ss, snapshot::kind::mvnorm, sizeof(double));
+    snapshot::write_vector(ss, tmeans);
+    snapshot::write_matrix(ss, tsigma);
+    snapshot::write_matrix(ss, lower);
+    snapshot::write_state(ss, std::normal_distribution<double>());
+
+    mvnorm_distribution<double> restored{tmeans, tsigma};
+    ss >> restored;
+
+    BOOST_CHECK( !ss );
+    BOOST_CHECK( approx_equal(restored.param().covs_lower(), tlower,
+                              "absdiff", 0) );
+
+    std::stringstream ts(std::ios::in | std::ios::out | std::ios::binary);
+    snapshot::write_header(ts, snapshot::kind::mv_t, sizeof(double));
+    snapshot::write_pod(ts, 4.0);
+    snapshot::write_vector(ts, tmeans);
+    snapshot::write_matrix(ts, tsigma);
+    snapshot::write_matrix(ts, lower);
+    snapshot::write_state(ts, std::normal_distribution<double>());
+    snapshot::write_state(ts, std::chi_squared_distribution<double>());
+
+    mv_t_distribution<double> trestored{4, tmeans, tsigma};
+    ts >> trestored;
+
+    BOOST_CHECK( !ts );
+    BOOST_CHECK( approx_equal(trestored.param().covs_lower(), tlower,
+                              "absdiff", 0) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( snapshot_kind_mismatch_test )
+{
+  mvnorm_distribution<double> mvnorm{{1, 2}, {{1, 0}, {0, 1}}};
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  ss << mvnorm;
+
+  truncated_normal_distribution<double> tnorm{0, 1, -1, 1};
+  ss >> tnorm;
+
+  BOOST_CHECK( !ss );
+  BOOST_CHECK( tnorm == truncated_normal_distribution<double>(0, 1, -1, 1) );
+}
+
+BOOST_AUTO_TEST_CASE( snapshot_oversized_test )
+{
+  const std::uint64_t huge = std::uint64_t(1) << 40;
+
+  // sizes whose product overflows, and sizes longer than the stream
+  for (std::uint64_t rows : {huge, std::numeric_limits<std::uint64_t>::max()}) {
+    std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+    snapshot::write_pod(ss, rows);
+    snapshot::write_pod(ss, huge);
+    snapshot::write_pod(ss, 1.0);
+
+    arma::Mat<double> x(2, 2, arma::fill::ones);
+    snapshot::read_matrix(ss, x);
+    BOOST_CHECK( !ss );
+    BOOST_CHECK( x.n_rows == 2 && x.n_cols == 2 );
+  }
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  snapshot::write_pod(ss, huge);
+  std::string s;
+  snapshot::read_state(ss, s);
+  BOOST_CHECK( !ss );
+
+  // a truncated snapshot
+  mvnorm_distribution<double> mvnorm{{1, 2}, {{1, 0}, {0, 1}}};
+  std::stringstream full(std::ios::in | std::ios::out | std::ios::binary);
+  full << mvnorm;
+  std::stringstream cut(full.str().substr(0, full.str().size() - 8),
+                        std::ios::in | std::ios::out | std::ios::binary);
+
+  mvnorm_distribution<double> restored{{0, 0}, {{2, 0}, {0, 2}}};
+  const mvnorm_distribution<double> original = restored;
+  cut >> restored;
+
+  BOOST_CHECK( !cut );
+  BOOST_CHECK( restored == original );
+}
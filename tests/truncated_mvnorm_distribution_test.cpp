@@ -0,0 +1,79 @@
+#define BOOST_TEST_MODULE TRUNCATED_MVNORM_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <random>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/mvnorm_distribution.h"
+#include "dists/truncated_mvnorm_distribution.h"
+
+using namespace baaraan;
+
+BOOST_AUTO_TEST_CASE( truncated_mvnorm_moments_test )
+{
+  arma::Col<double> tmeans {0, 0.5, -0.5};
+  arma::Mat<double> tsigma{{1, 0.6, 0.2}, {0.6, 1.5, -0.3}, {0.2, -0.3, 0.8}};
+  arma::Col<double> tlowers {-1, -0.5, -1.5};
+  arma::Col<double> tuppers {1.5, 2, 0.5};
+
+  const size_t n = 100000;
+
+  // reference draws, by rejecting normal draws outside of the bounds
+  mvnorm_distribution<double> mvnorm{tmeans, tsigma};
+  std::mt19937 gen(7);
+
+  arma::Mat<double> reference(3, n);
+  for (size_t k = 0; k < n;) {
+    arma::Col<double> x = mvnorm(gen);
+    if (arma::all(x >= tlowers) && arma::all(x <= tuppers))
+      reference.col(k++) = x;
+  }
+
+  // the Gibbs chain, with its conditionals derived from the precision matrix
+  truncated_mvnorm_distribution<double> tmvnorm{tmeans, tsigma, tlowers,
+                                                tuppers};
+  gen.seed(42);
+
+  arma::Mat<double> sample(3, n);
+  sample.each_col([&](arma::Col<double> &v) { v = tmvnorm(gen); });
+
+  BOOST_CHECK( arma::all(arma::min(sample, 1) >= tlowers) );
+  BOOST_CHECK( arma::all(arma::max(sample, 1) <= tuppers) );
+
+  BOOST_CHECK( approx_equal(arma::mean(sample, 1), arma::mean(reference, 1),
+                            "absdiff", 0.02) );
+  BOOST_CHECK( approx_equal(arma::cov(sample.t()), arma::cov(reference.t()),
+                            "absdiff", 0.02) );
+}
+
+BOOST_AUTO_TEST_CASE( truncated_mvnorm_param_change_restarts_chain_test )
+{
+  arma::Col<double> tmeans {0, 0};
+  arma::Mat<double> tsigma{{1, 0.8}, {0.8, 1}};
+
+  typedef truncated_mvnorm_distribution<double>::param_type param_type;
+  const param_type low{tmeans, tsigma, {-3, -3}, {-1, -1}};
+  const param_type high{tmeans, tsigma, {1, 1}, {3, 3}};
+
+  truncated_mvnorm_distribution<double> tmvnorm{low};
+  truncated_mvnorm_distribution<double> fresh{high};
+
+  std::mt19937 gen(42);
+  for (int i = 0; i < 10; ++i)
+    tmvnorm(gen);
+
+  // with different parameters, the chain starts over from their own means,
+  // exactly like a new distribution
+  std::mt19937 gen2 = gen;
+  for (int i = 0; i < 5; ++i) {
+    arma::Col<double> x = tmvnorm(gen, high);
+    BOOST_CHECK( arma::all(x >= 1) && arma::all(x <= 3) );
+    BOOST_CHECK( approx_equal(x, fresh(gen2), "absdiff", 0) );
+  }
+
+  // and back again on its own parameters
+  gen2 = gen;
+  truncated_mvnorm_distribution<double> fresh_low{low};
+  BOOST_CHECK( approx_equal(tmvnorm(gen), fresh_low(gen2), "absdiff", 0) );
+}
@@ -0,0 +1,114 @@
+#define BOOST_TEST_MODULE WISHART_DISTRIBUTION TEST
+#define BOOST_TEST_DYN_LINK
+
+#include <random>
+
+#include "boost/test/unit_test.hpp"
+
+#include "dists/wishart_distribution.h"
+#include "dists/inverse_wishart_distribution.h"
+
+using namespace baaraan;
+
+BOOST_AUTO_TEST_CASE( wishart_mean_test )
+{
+  arma::Mat<double> tscale{{1, 0.5, 0}, {0.5, 2, 0.3}, {0, 0.3, 1}};
+  wishart_distribution<double> wishart{6, tscale};
+
+  std::mt19937 gen(42);
+
+  arma::Cube<double> sample = wishart(gen, 20000);
+  arma::Mat<double> mean = arma::mean(sample, 2);
+
+  BOOST_CHECK( approx_equal(mean, wishart.mean(), "absdiff", 0.2) );
+}
+
+BOOST_AUTO_TEST_CASE( inverse_wishart_mean_test )
+{
+  arma::Mat<double> tscale{{1, 0.5, 0}, {0.5, 2, 0.3}, {0, 0.3, 1}};
+  inverse_wishart_distribution<double> iwishart{10, tscale};
+
+  std::mt19937 gen(42);
+
+  arma::Mat<double> mean(3, 3, arma::fill::zeros);
+  for (int i = 0; i < 20000; ++i)
+    mean += iwishart(gen);
+  mean /= 20000;
+
+  BOOST_CHECK( approx_equal(mean, iwishart.mean(), "absdiff", 0.02) );
+}
+
+BOOST_AUTO_TEST_CASE( wishart_variance_test )
+{
+  arma::Mat<double> tscale{{1, 0.5, 0}, {0.5, 2, 0.3}, {0, 0.3, 1}};
+  wishart_distribution<double> wishart{6, tscale};
+
+  std::mt19937 gen(42);
+
+  arma::Cube<double> sample = wishart(gen, 50000);
+  arma::Mat<double> mean = arma::mean(sample, 2);
+  arma::Mat<double> var = arma::mean(sample % sample, 2);
+  var -= mean % mean;
+
+  // Var(W_ij) = dof (S_ij^2 + S_ii S_jj)
+  arma::Col<double> d = tscale.diag();
+  arma::Mat<double> tvar = 6 * (tscale % tscale + d * d.t());
+
+  BOOST_CHECK( approx_equal(var, tvar, "reldiff", 0.1) );
+}
+
+BOOST_AUTO_TEST_CASE( wishart_fractional_dof_test )
+{
+  arma::Mat<double> tscale{{1, 0.5, 0}, {0.5, 2, 0.3}, {0, 0.3, 1}};
+  wishart_distribution<double> wishart{2.5, tscale};
+
+  std::mt19937 gen(42);
+
+  arma::Cube<double> sample = wishart(gen, 50000);
+  arma::Mat<double> mean = arma::mean(sample, 2);
+
+  BOOST_CHECK( approx_equal(mean, wishart.mean(), "absdiff", 0.1) );
+}
+
+BOOST_AUTO_TEST_CASE( wishart_batch_test )
+{
+  arma::Mat<double> tscale{{1, 0.5, 0}, {0.5, 2, 0.3}, {0, 0.3, 1}};
+  wishart_distribution<double> wishart{4.5, tscale}, single = wishart;
+
+  std::mt19937 gen1(42), gen2(42);
+
+  arma::Cube<double> sample = wishart(gen1, 20);
+  for (size_t k = 0; k < sample.n_slices; ++k)
+    BOOST_CHECK( approx_equal(sample.slice(k), single(gen2), "absdiff", 0) );
+}
+
+BOOST_AUTO_TEST_CASE( inverse_wishart_batch_test )
+{
+  arma::Mat<double> tscale{{1, 0.5, 0}, {0.5, 2, 0.3}, {0, 0.3, 1}};
+  inverse_wishart_distribution<double> iwishart{10, tscale}, single = iwishart;
+
+  std::mt19937 gen1(42), gen2(42);
+
+  arma::Cube<double> sample = iwishart(gen1, 20);
+  for (size_t k = 0; k < sample.n_slices; ++k)
+    BOOST_CHECK( approx_equal(sample.slice(k), single(gen2), "absdiff", 0) );
+
+  sample = iwishart(gen1, 20000);
+  arma::Mat<double> mean = arma::mean(sample, 2);
+
+  BOOST_CHECK( approx_equal(mean, iwishart.mean(), "absdiff", 0.02) );
+}
+
+BOOST_AUTO_TEST_CASE( wishart_invalid_param_test )
+{
+  arma::Mat<double> tscale{{1, 0.5, 0}, {0.5, 2, 0.3}, {0, 0.3, 1}};
+  arma::Mat<double> asym{{1, 0.5, 0}, {0.4, 2, 0.3}, {0, 0.3, 1}};
+
+  BOOST_CHECK_THROW( wishart_distribution<double>(2, tscale),
+                     std::logic_error );
+  BOOST_CHECK_THROW( wishart_distribution<double>(6, asym), std::logic_error );
+  BOOST_CHECK_THROW( inverse_wishart_distribution<double>(1.5, tscale),
+                     std::logic_error );
+  BOOST_CHECK_THROW( inverse_wishart_distribution<double>(6, asym),
+                     std::logic_error );
+}